@@ -0,0 +1,35 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "src/Analysis/SortBenchmark.h"
+
+// SortBenchmark <input root> <results.csv> [--warmups N] [--reps N] [--arrays N] [--algorithms a,b,...]
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0]
+                  << " <input root> <results.csv> [--warmups N] [--reps N] [--arrays N] [--algorithms a,b,...]\n";
+        for (const auto& alg : SortBenchmark::registry()) std::cerr << "  " << alg.name << "\n";
+        return 2;
+    }
+
+    SortBenchmark::Options opt;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        const std::string flag = argv[i];
+        const std::string value = argv[i + 1];
+        if (flag == "--warmups")         opt.warmups = std::stoi(value);
+        else if (flag == "--reps")       opt.repetitions = std::stoi(value);
+        else if (flag == "--arrays")     opt.maxArraysPerSet = std::stoi(value);
+        else if (flag == "--algorithms") {
+            std::stringstream ss(value);
+            std::string name;
+            while (std::getline(ss, name, ',')) opt.algorithms.push_back(name);
+        } else {
+            std::cerr << "unknown option " << flag << "\n";
+            return 2;
+        }
+    }
+
+    SortBenchmark().run(argv[1], argv[2], opt);
+    return 0;
+}
@@ -0,0 +1,20 @@
+# The sweep main.cpp used to hard-code: n = 10000, 1000 arrays per set, samples of 100.
+# Run with: DisorderMetrics experiments/sqrt_sampling.spec
+
+root    = src/experiment_data_input
+output  = src/experiment_data_output
+
+sizes       = 10000
+count       = 1000
+sample_size = 100
+min_value   = 0
+max_value   = n
+
+types = permutation, random, runs
+k     = 2500, 5000, 7500, 9000
+runs  = 13, 100, 200, 1000, 2500, sqrt n, 2sqrt n, log2 n, n div 4, n div 10, n div 20
+
+cluster_groups = sqrt, 2sqrt, log2, 2log2, smlLength
+stratum_groups = smlLength, 2 smlLength, n div 4, n div 10, n div 20
+
+evaluate = metrics
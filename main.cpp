@@ -4,6 +4,7 @@
 #include "src/Algotrithms/MergeSort.h"
 #include "src/Algotrithms/PowerSort.h"
 #include "src/Analysis/Evaluator.h"
+#include "src/Analysis/ExperimentPlanner.h"
 #include "src/Data/DataGenerator.h"
 #include "src/Data/Sampler.h"
 #include "src/Analysis/DisorderMetrics.h"
@@ -11,8 +12,15 @@
 
 namespace fs = std::filesystem;
 // TIP To <b>Run</b> code, press <shortcut actionId="Run"/> or click the <icon src="AllIcons.Actions.Execute"/> icon in the gutter.
-int main() {
-
+int main(int argc, char** argv) {
+
+    // DisorderMetrics <spec file>: run the sweep described there (see ExperimentSpec.h)
+    if (argc > 1) {
+        ExperimentPlanner planner(ExperimentSpec::load(argv[1]));
+        std::cout << "[PLAN] " << planner.tasks().size() << " tasks from " << argv[1] << "\n";
+        planner.run();
+        return 0;
+    }
 
     // ExperimentConfigurator configurator(
     //        10000, 100, 0, 10000,
@@ -1,114 +1,91 @@
 
 #include "AdaptiveShiversSort.h"
 
-#include <chrono>
+#include <bit>
+#include <cstdint>
 
 
-struct Run {
-    int start;
-    int end;
-    int length() const { return end - start; }
-};
-
-std::vector<int> AdaptiveShiversSort::sort(std::vector<int>& array) {
-    std::vector<int> arr = array;
-    swapCount = 0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    adaptiveShiversSort(arr, 3);
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> runtime = end - start;
-
-    std::cout << "Swaps: " << swapCount << std::endl;
-    std::cout << "Runtime: " << runtime.count() << " seconds" << std::endl;
-
-    return arr;
+template <class Counter>
+SortStats AdaptiveShiversSort<Counter>::sort(std::span<int> array) {
+    counter = Counter{};
+    adaptiveShiversSort(array, 3);
+    return counter.stats();
 }
 
-
-void AdaptiveShiversSort:: mergeRuns(std::vector<int>& A, Run& R1, Run& R2) {
-    std::vector<int> temp;
-    int i = R1.start, j = R2.start;
-    while (i <= R1.end && j <= R2.end) {
-        if (A[i] <= A[j]) temp.push_back(A[i++]);
-        else temp.push_back(A[j++]);
-    }
-    while (i <= R1.end) temp.push_back(A[i++]);
-    while (j <= R2.end) temp.push_back(A[j++]);
-
-    for (int k = 0; k < temp.size(); ++k) {
-        A[R1.start + k] = temp[k];
-    }
-
-    R1.end = R2.end;
+// floor(log2(length / c)) in integers. length / c is scaled by 2^8 first (c <= 256), so the
+// truncating division keeps the integer part of the logarithm exact, also below c.
+template <class Counter>
+int AdaptiveShiversSort<Counter>::level(size_t length, int c) {
+    const std::uint64_t scaled = (static_cast<std::uint64_t>(length) << 8) / static_cast<std::uint64_t>(c);
+    return static_cast<int>(std::bit_width(scaled)) - 9;
 }
 
-std::vector<Run> AdaptiveShiversSort::  runDecomposition(const std::vector<int>& A) {
-    std::vector<Run> runs;
-    int n = A.size();
-    if (n == 0) return runs;
-
-    int start = 0;
-    for (int i = 1; i < n; ++i) {
-        if (A[i] < A[i-1]) {
-            runs.push_back({start, i-1});
+template <class Counter>
+void AdaptiveShiversSort<Counter>::runDecomposition(std::span<const int> A, int c) {
+    runs.clear();
+    const size_t n = A.size();
+    if (n == 0) return;
+
+    size_t start = 0;
+    for (size_t i = 1; i < n; ++i) {
+        counter.compare();
+        if (A[i] < A[i - 1]) {
+            runs.push_back({start, i, level(i - start, c)});
             start = i;
         }
     }
-    runs.push_back({start, n-1});
-    return runs;
+    runs.push_back({start, n, level(n - start, c)});
 }
 
-void AdaptiveShiversSort:: adaptiveShiversSort(std::vector<int>& A, int c) {
-    std::vector<Run> runs = runDecomposition(A);
-    std::vector<Run> S;
-
-    auto l = [&](const Run& r) -> int {
-        return (int)std::floor(std::log2(r.length() / (double)c));
-    };
+template <class Counter>
+void AdaptiveShiversSort<Counter>::adaptiveShiversSort(std::span<int> A, int c) {
+    runDecomposition(A, c);
+    stack.clear();
 
+    // runs are pushed right to left, so top(i + 1) lies right of top(i)
     while (true) {
-        int h = S.size();
-
-        auto top = [&](int i) -> Run& {
-            return S[S.size() - i];
-        };
-
-        if (h >= 3 && l(top(1)) >= l(top(3))) {
-            Run R2 = top(2);
-            Run R3 = top(3);
-            mergeRuns(A, R2, R3);
-            S.erase(S.end() - 3, S.end() - 1);
-            S.push_back(R2);
-        } else if (h >= 3 && l(top(2)) >= l(top(3))) {
-            Run R2 = top(2);
-            Run R3 = top(3);
-            mergeRuns(A, R2, R3);
-            S.erase(S.end() - 3, S.end() - 1);
-            S.push_back(R2);
-        } else if (h >= 2 && l(top(1)) >= l(top(2))) {
-            Run R1 = top(1);
-            Run R2 = top(2);
-            mergeRuns(A, R1, R2);
-            S.erase(S.end() - 2, S.end());
-            S.push_back(R1);
+        const size_t h = stack.size();
+        auto top = [&](size_t i) -> Run& { return stack[h - i]; };
+
+        if (h >= 3 && (top(1).level >= top(3).level || top(2).level >= top(3).level)) {
+            mergeRuns(A, top(2), top(3), c);
+            top(3) = top(2);
+            top(2) = top(1);
+            stack.pop_back();
+        } else if (h >= 2 && top(1).level >= top(2).level) {
+            mergeRuns(A, top(1), top(2), c);
+            top(2) = top(1);
+            stack.pop_back();
         } else if (!runs.empty()) {
-            S.push_back(runs.back());
+            stack.push_back(runs.back());
             runs.pop_back();
         } else {
             break;
         }
     }
 
-
-    while (S.size() > 1) {
-        Run R1 = S[S.size() - 2];
-        Run R2 = S[S.size() - 1];
-        mergeRuns(A, R1, R2);
-        S.pop_back();
-        S.pop_back();
-        S.push_back(R1);
+    // the top of the stack is the leftmost run
+    while (stack.size() > 1) {
+        const size_t h = stack.size();
+        mergeRuns(A, stack[h - 1], stack[h - 2], c);
+        stack[h - 2] = stack[h - 1];
+        stack.pop_back();
     }
-}
\ No newline at end of file
+}
+
+template <class Counter>
+void AdaptiveShiversSort<Counter>::mergeRuns(std::span<int> A, Run& left, const Run& right, int c) {
+    int* a = A.data();
+    const size_t lo = left.start, mid = right.start, hi = right.end;
+    counter.merge(hi - lo);
+    left.end = hi;
+    left.level = level(hi - lo, c);
+
+    GallopingMerge::merge(a + lo, a + mid, a + hi, buffer, [this](int x, int y) {
+        counter.compare();
+        return x < y;
+    }, counter);
+}
+
+template class AdaptiveShiversSort<NullCounter>;
+template class AdaptiveShiversSort<CountingCounter>;
@@ -2,32 +2,46 @@
 
 #ifndef ADAPTIVESHIVERSSORT_H
 #define ADAPTIVESHIVERSSORT_H
-#include <cmath>
-#include <functional>
-#include <stack>
+#include <span>
+#include <vector>
 
+#include "GallopingMerge.h"
 #include "SortingAlgorithm.h"
 
 
-struct Run;
-
+// Jugé's adaptive ShiversSort over the non-descending runs of the array, pushed right to
+// left: the top runs are merged while their levels floor(log2(length / c)) allow it, c = 3.
+// Merges go through GallopingMerge (the same merge as PowerSort's): the prefix and suffix
+// already in place are skipped, the shorter run is buffered, and galloping starts after
+// MIN_GALLOP consecutive wins of one side. The buffer and both run vectors are reused across
+// sort() calls.
+template <class Counter = NullCounter>
 class AdaptiveShiversSort: public SortAlgorithm {
 public:
-    // Статистика
-    long long totalMergeCosts = 0;
-    long long totalBufferCosts = 0;
-    long long swapCount = 0;
+    static constexpr size_t MIN_GALLOP = GallopingMerge::MIN_GALLOP;
 
-    std::vector<int> sort(std::vector<int> &array);
+    SortStats sort(std::span<int> array) override;
 
 private:
+    struct Run {
+        size_t start;
+        size_t end; // exclusive
+        int level;
+    };
+
+    Counter counter;
+    std::vector<int> buffer;
+    std::vector<Run> runs;
+    std::vector<Run> stack;
 
-    void mergeRuns(std::vector<int>& A, Run& R1, Run& R2);
+    static int level(size_t length, int c);
 
-std::vector<Run> runDecomposition(const std::vector<int>& A);
+    void runDecomposition(std::span<const int> A, int c);
 
-void adaptiveShiversSort(std::vector<int>& A, int c);
+    void adaptiveShiversSort(std::span<int> A, int c);
 
+    // Merges the adjacent runs `left` and `right` into `left`.
+    void mergeRuns(std::span<int> A, Run& left, const Run& right, int c);
 
 };
 #endif //ADAPTIVESHIVERSSORT_H
@@ -2,30 +2,20 @@
 
 #include "BinaryInsertionSort.h"
 
-#include <chrono>
-#include <iostream>
 
-
-std::vector<int> BinaryInsertionSort:: sort(std::vector<int>& array) {
-    std::vector<int> arr = array;
-    swapCount = 0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    binaryInsertionSort(arr);
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> runtime = end - start;
-
-    std::cout << "Swaps: " << swapCount << std::endl;
-    std::cout << "Runtime: " << runtime.count() << " seconds" << std::endl;
-
-    return arr;
+template <class Counter>
+SortStats BinaryInsertionSort<Counter>:: sort(std::span<int> array) {
+    counter = Counter{};
+    binaryInsertionSort(array);
+    return counter.stats();
 }
 
-int BinaryInsertionSort:: binarySearch(const std::vector<int>& arr, int key, int low, int high) {
+// First position in [low, high) whose element is greater than key (keeps equal keys stable).
+template <class Counter>
+size_t BinaryInsertionSort<Counter>:: binarySearch(std::span<const int> arr, int key, size_t low, size_t high) {
     while (low < high) {
-        int mid = low + (high - low) / 2;
+        size_t mid = low + (high - low) / 2;
+        counter.compare();
         if (arr[mid] <= key)
             low = mid + 1;
         else
@@ -34,17 +24,22 @@ int BinaryInsertionSort:: binarySearch(const std::vector<int>& arr, int key, int
     return low;
 }
 
-void BinaryInsertionSort::  binaryInsertionSort(std::vector<int>& arr) {
-    int n = arr.size();
-    for (int i = 1; i < n; ++i) {
+template <class Counter>
+void BinaryInsertionSort<Counter>::  binaryInsertionSort(std::span<int> arr) {
+    size_t n = arr.size();
+    for (size_t i = 1; i < n; ++i) {
         int key = arr[i];
 
 
-        int pos = binarySearch(arr, key, 0, i);
+        size_t pos = binarySearch(arr, key, 0, i);
 
-        for (int j = i; j > pos; --j)
+        for (size_t j = i; j > pos; --j)
             arr[j] = arr[j - 1];
 
         arr[pos] = key;
+        counter.move(i - pos + 1);
     }
-}
\ No newline at end of file
+}
+
+template class BinaryInsertionSort<NullCounter>;
+template class BinaryInsertionSort<CountingCounter>;
@@ -2,22 +2,24 @@
 
 #ifndef BINARYINSERTIONSORT_H
 #define BINARYINSERTIONSORT_H
-#include <vector>
+#include <span>
 
 #include "SortingAlgorithm.h"
 
 
+template <class Counter = NullCounter>
 class BinaryInsertionSort: public SortAlgorithm {
 
 public:
-    std::vector<int> sort(std::vector<int>& array);
+    SortStats sort(std::span<int> array) override;
 
 
 private:
+    Counter counter;
 
-    int binarySearch(const std::vector<int>& arr, int key, int low, int high);
+    size_t binarySearch(std::span<const int> arr, int key, size_t low, size_t high);
 
-    void binaryInsertionSort(std::vector<int>& arr);
+    void binaryInsertionSort(std::span<int> arr);
 };
 
 
@@ -0,0 +1,136 @@
+#ifndef GALLOPINGMERGE_H
+#define GALLOPINGMERGE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+// Stable merge of two adjacent sorted runs, shared by PowerSort and AdaptiveShiversSort.
+// The prefix and suffix already in place are skipped, the shorter run goes to a caller-owned
+// buffer (grown as needed), and the merge switches to galloping after MIN_GALLOP consecutive
+// wins of one side. `less(x, y)` compares two elements and reports the comparison to the
+// counter itself; `counter` gets the moves and buffer traffic.
+class GallopingMerge {
+public:
+    static constexpr size_t MIN_GALLOP = 7;
+
+    // Merges the sorted runs [lo, mid) and [mid, hi).
+    template <class It, class Buffer, class Less, class Counter>
+    static void merge(It lo, It mid, It hi, Buffer& buffer, Less less, Counter& counter) {
+        const auto [from, to] = trim(lo, mid, hi, less);
+        if (from < to) mergeTrimmed(from, mid, to, buffer, less, counter);
+    }
+
+    // The part [from, to) of merging [lo, mid) and [mid, hi) that is not already in place:
+    // left elements not greater than the first right one, and right elements not less than
+    // the last left one, stay where they are. Empty if the runs are in order.
+    template <class It, class Less>
+    static std::pair<It, It> trim(It lo, It mid, It hi, Less less) {
+        const It from = gallopForward<true>(lo, mid, *mid, less);
+        if (from == mid) return {mid, mid};
+        return {from, gallopBackward<false>(mid, hi, *(mid - 1), less)};
+    }
+
+    // Merges [lo, mid) and [mid, hi) through the buffer, which takes the shorter run.
+    template <class It, class Buffer, class Less, class Counter>
+    static void mergeTrimmed(It lo, It mid, It hi, Buffer& buffer, Less less, Counter& counter) {
+        const size_t n1 = static_cast<size_t>(mid - lo);
+        const size_t n2 = static_cast<size_t>(hi - mid);
+        if (buffer.size() < std::min(n1, n2)) buffer.resize(std::min(n1, n2));
+        if (n1 <= n2) mergeLo(lo, mid, hi, buffer, less, counter);
+        else mergeHi(lo, mid, hi, buffer, less, counter);
+    }
+
+    // Searches the sorted [lo, hi) from the front: first element not less than key (Upper:
+    // greater than key). Probes 1, 3, 7, ... elements in, then binary-searches the last gap.
+    template <bool Upper, class It, class T, class Less>
+    static It gallopForward(It lo, It hi, const T& key, Less& less) {
+        auto before = [&](const auto& x) { return Upper ? !less(key, x) : less(x, key); };
+        const size_t len = static_cast<size_t>(hi - lo);
+        size_t bound = 1;
+        while (bound <= len && before(lo[bound - 1])) bound *= 2;
+        return std::partition_point(lo + bound / 2, lo + std::min(bound, len), before);
+    }
+
+    // Same result as gallopForward, probing from the back.
+    template <bool Upper, class It, class T, class Less>
+    static It gallopBackward(It lo, It hi, const T& key, Less& less) {
+        auto before = [&](const auto& x) { return Upper ? !less(key, x) : less(x, key); };
+        const size_t len = static_cast<size_t>(hi - lo);
+        size_t bound = 1;
+        while (bound <= len && !before(hi[-static_cast<std::ptrdiff_t>(bound)])) bound *= 2;
+        return std::partition_point(hi - std::min(bound, len), hi - bound / 2, before);
+    }
+
+private:
+    // Left run buffered, merged front to back.
+    template <class It, class Buffer, class Less, class Counter>
+    static void mergeLo(It lo, It mid, It hi, Buffer& buffer, Less& less, Counter& counter) {
+        const auto buf = buffer.begin();
+        const size_t n1 = static_cast<size_t>(mid - lo);
+        std::move(lo, mid, buf);
+        counter.buffer(n1);
+
+        auto b = buf, bEnd = buf + n1;
+        It j = mid, k = lo;
+        size_t winsL = 0, winsR = 0;
+        while (b < bEnd && j < hi) {
+            if (winsL < MIN_GALLOP && winsR < MIN_GALLOP) {
+                if (less(*j, *b)) { *k++ = std::move(*j++); ++winsR; winsL = 0; }
+                else              { *k++ = std::move(*b++); ++winsL; winsR = 0; }
+                counter.move();
+                continue;
+            }
+            const It jStop = gallopForward<false>(j, hi, *b, less);
+            const size_t cr = static_cast<size_t>(jStop - j);
+            k = std::move(j, jStop, k);
+            j = jStop;
+            if (j == hi) { counter.move(cr); break; }
+            const auto bStop = gallopForward<true>(b, bEnd, *j, less);
+            const size_t cl = static_cast<size_t>(bStop - b);
+            k = std::move(b, bStop, k);
+            b = bStop;
+            counter.move(cr + cl);
+            if (cr < MIN_GALLOP && cl < MIN_GALLOP) winsL = winsR = 0;
+        }
+        counter.move(static_cast<std::uint64_t>(bEnd - b));
+        std::move(b, bEnd, k);
+    }
+
+    // Right run buffered, merged back to front.
+    template <class It, class Buffer, class Less, class Counter>
+    static void mergeHi(It lo, It mid, It hi, Buffer& buffer, Less& less, Counter& counter) {
+        const auto buf = buffer.begin();
+        const size_t n2 = static_cast<size_t>(hi - mid);
+        std::move(mid, hi, buf);
+        counter.buffer(n2);
+
+        auto b = buf + n2;
+        It i = mid, k = hi;
+        size_t winsL = 0, winsR = 0;
+        while (b > buf && i > lo) {
+            if (winsL < MIN_GALLOP && winsR < MIN_GALLOP) {
+                if (less(b[-1], i[-1])) { *--k = std::move(*--i); ++winsL; winsR = 0; }
+                else                    { *--k = std::move(*--b); ++winsR; winsL = 0; }
+                counter.move();
+                continue;
+            }
+            const It iStop = gallopBackward<true>(lo, i, b[-1], less);
+            const size_t cl = static_cast<size_t>(i - iStop);
+            k = std::move_backward(iStop, i, k);
+            i = iStop;
+            if (i == lo) { counter.move(cl); break; }
+            const auto bStop = gallopBackward<false>(buf, b, i[-1], less);
+            const size_t cr = static_cast<size_t>(b - bStop);
+            k = std::move_backward(bStop, b, k);
+            b = bStop;
+            counter.move(cl + cr);
+            if (cl < MIN_GALLOP && cr < MIN_GALLOP) winsL = winsR = 0;
+        }
+        counter.move(static_cast<std::uint64_t>(b - buf));
+        std::move(buf, b, lo);
+    }
+};
+
+#endif //GALLOPINGMERGE_H
@@ -2,40 +2,31 @@
 
 #include "InsertionSort.h"
 
-#include <chrono>
-
-void InsertionSort:: insertionSort(std::vector<int> arr) {
-    swapCount = 0;
-
-    for (int i = 1; i < arr.size(); i++) {
+template <class Counter>
+void InsertionSort<Counter>:: insertionSort(std::span<int> arr) {
+    for (size_t i = 1; i < arr.size(); i++) {
         int key = arr[i];
-        int j = i - 1;
+        size_t j = i;
 
-        while (j >= 0 && arr[j] > key) {
-            arr[j + 1] = arr[j];
-            swapCount++;
+        while (j > 0) {
+            counter.compare();
+            if (!(arr[j - 1] > key)) break;
+            arr[j] = arr[j - 1];
+            counter.move();
             j--;
         }
-        arr[j + 1] = key;
-        swapCount++;
+        arr[j] = key;
+        counter.move();
     }
 
 }
 
-std::vector<int> InsertionSort::sort(std::vector<int> array) {
-    std::vector<int> arr = array;
-    swapCount = 0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    insertionSort(arr);
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> runtime = end - start;
-
-    std::cout << "Swaps: " << swapCount << std::endl;
-    std::cout << "Runtime: " << runtime.count() << " seconds" << std::endl;
-
-    return arr;
+template <class Counter>
+SortStats InsertionSort<Counter>::sort(std::span<int> array) {
+    counter = Counter{};
+    insertionSort(array);
+    return counter.stats();
 }
 
+template class InsertionSort<NullCounter>;
+template class InsertionSort<CountingCounter>;
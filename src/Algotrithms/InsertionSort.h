@@ -2,18 +2,21 @@
 
 #ifndef INSERTIONSORT_H
 #define INSERTIONSORT_H
-#include <vector>
+#include <span>
 
 #include "SortingAlgorithm.h"
 
 
+template <class Counter = NullCounter>
 class InsertionSort: public SortAlgorithm{
 
 public:
-    std::vector<int> sort(std::vector<int> arr);
+    SortStats sort(std::span<int> array) override;
 
 private:
-    void insertionSort(std::vector<int> arr);
+    Counter counter;
+
+    void insertionSort(std::span<int> arr);
 
 
 };
@@ -2,144 +2,65 @@
 
 #include "MergeSort.h"
 
-#include <chrono>
-#include <iostream>
-#include <vector>
+#include <algorithm>
 
 
-template<typename T>
-T plus_inf_sentinel() {
-    return std::numeric_limits<T>::max();
+template <class Counter>
+SortStats MergeSort<Counter>::sort(std::span<int> array) {
+    counter = Counter{};
+    buffer.resize(array.size() / 2 + 1);
+    mergeSort(array, 0, array.size());
+    return counter.stats();
 }
 
-std::vector<int> MergeSort::sort(std::vector<int>& array) {
-    swapCount = 0;
-    totalMergeCosts = 0;
-    totalBufferCosts = 0;
 
-    auto start = std::chrono::high_resolution_clock::now();
-    std::vector<int> arr = array;
-    if (!arr.empty())
-        mergeSort(arr, 0, arr.size() - 1);
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> runtime = end - start;
-
-    std::cout << "Swaps: " << swapCount << std::endl;
-    std::cout << "Merge costs: " << totalMergeCosts << std::endl;
-    std::cout << "Buffer costs: " << totalBufferCosts << std::endl;
-    std::cout << "Runtime: " << runtime.count() << " seconds" << std::endl;
-
-    return arr;
-}
-
-void MergeSort:: merge(std::vector<int>& arr, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-
-    std::vector<int> L(n1);
-    std::vector<int> R(n2);
-
-    for (int i = 0; i < n1; i++) L[i] = arr[left + i];
-    for (int j = 0; j < n2; j++) R[j] = arr[mid + 1 + j];
-
-    int i = 0, j = 0, k = left;
-
-    while (i < n1 && j < n2) {
-        if (L[i] <= R[j]) {
-            arr[k++] = L[i++];
-        } else {
-            arr[k++] = R[j++];
-        }
-        swapCount++;
-    }
-
-    while (i < n1) {
-        arr[k++] = L[i++];
-        swapCount++;
-    }
-
-    while (j < n2) {
-        arr[k++] = R[j++];
-        swapCount++;
-    }
-}
-
-
-void MergeSort:: merge_runs_copy_half(std::vector<int>& A, int l, int m, int r, std::vector<int>& B) {
-    int n1 = m - l;
-    int n2 = r - m;
-    if (COUNT_MERGE_COSTS) totalMergeCosts += (n1 + n2);
+// Merges [l, m) and [m, r). The shorter run goes to the buffer: a left run is merged
+// front to back, a right run back to front, so neither overwrites unread elements.
+template <class Counter>
+void MergeSort<Counter>:: merge_runs_copy_half(std::span<int> A, size_t l, size_t m, size_t r) {
+    const size_t n1 = m - l;
+    const size_t n2 = r - m;
+    counter.merge(n1 + n2);
 
     if (n1 <= n2) {
+        std::copy(A.begin() + l, A.begin() + m, buffer.begin());
+        counter.buffer(n1);
 
-        std::copy(A.begin() + l, A.begin() + m, B.begin());
-        if (COUNT_MERGE_COSTS) totalBufferCosts += n1;
-
-        int i = 0, j = m, k = l;
-        while (i < n1 && j < r)
-            A[k++] = (B[i] <= A[j]) ? B[i++] : A[j++];
-        while (i < n1)
-            A[k++] = B[i++];
+        size_t i = 0, j = m, k = l;
+        while (i < n1 && j < r) {
+            counter.compare();
+            A[k++] = (buffer[i] <= A[j]) ? buffer[i++] : A[j++];
+        }
+        counter.move(k - l);
+        std::copy(buffer.begin() + i, buffer.begin() + n1, A.begin() + k);
+        counter.move(n1 - i);
     } else {
-        std::copy(A.begin() + m, A.begin() + r, B.begin());
-        if (COUNT_MERGE_COSTS) totalBufferCosts += n2;
+        std::copy(A.begin() + m, A.begin() + r, buffer.begin());
+        counter.buffer(n2);
 
-        int i = m - 1, j = n2 - 1, k = r - 1;
-        while (i >= l && j >= 0)
-            A[k--] = (A[i] <= B[j]) ? B[j--] : A[i--];
-        while (j >= 0)
-            A[k--] = B[j--];
+        size_t i = m, j = n2, k = r;
+        while (i > l && j > 0) {
+            counter.compare();
+            A[--k] = (A[i - 1] <= buffer[j - 1]) ? buffer[--j] : A[--i];
+        }
+        counter.move(r - k);
+        std::copy(buffer.begin(), buffer.begin() + j, A.begin() + l);
+        counter.move(j);
     }
 }
 
+// Sorts [left, right).
+template <class Counter>
+void MergeSort<Counter>:: mergeSort(std::span<int> A, size_t left, size_t right) {
+    if (right - left > 1) {
+        const size_t mid = left + (right - left) / 2;
 
-void MergeSort:: merge_runs_basic(std::vector<int>& A, int l, int m, int r, std::vector<int>& B) {
-    int n1 = m - l;
-    int n2 = r - m;
-    if (COUNT_MERGE_COSTS) totalMergeCosts += (n1 + n2);
-
-    std::copy(A.begin() + l, A.begin() + r, B.begin());
-    if (COUNT_MERGE_COSTS) totalBufferCosts += (n1 + n2);
-
-    int i = 0, j = n1, k = l;
-    while (i < n1 && j < n1 + n2)
-        A[k++] = (B[i] <= B[j]) ? B[i++] : B[j++];
-    while (i < n1)
-        A[k++] = B[i++];
-    while (j < n1 + n2)
-        A[k++] = B[j++];
-}
-
-
-void MergeSort:: merge_runs_basic_sentinels(std::vector<int>& A, int l, int m, int r, std::vector<int>& B) {
-    using T = int;
-    int n1 = m - l;
-    int n2 = r - m;
-    if (COUNT_MERGE_COSTS) totalMergeCosts += (n1 + n2);
+        mergeSort(A, left, mid);
+        mergeSort(A, mid, right);
 
-    for (int i = 0; i < n1; i++) B[i] = A[l + i];
-    B[n1] = plus_inf_sentinel<T>();
-
-    for (int j = 0; j < n2; j++) B[n1 + 1 + j] = A[m + j];
-    B[n1 + n2 + 1] = plus_inf_sentinel<T>();
-
-    if (COUNT_MERGE_COSTS) totalBufferCosts += (n1 + n2 + 2);
-
-    int i = 0, j = n1 + 1, k = l;
-    while (k < r)
-        A[k++] = (B[i] <= B[j]) ? B[i++] : B[j++];
-}
-
-void MergeSort:: mergeSort(std::vector<int>& arr, int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-
-        mergeSort(arr, left, mid);
-        mergeSort(arr, mid + 1, right);
-
-        merge(arr, left, mid, right);
+        merge_runs_copy_half(A, left, mid, right);
     }
 }
 
-
+template class MergeSort<NullCounter>;
+template class MergeSort<CountingCounter>;
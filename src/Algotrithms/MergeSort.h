@@ -2,32 +2,29 @@
 
 #ifndef MERGESORT_H
 #define MERGESORT_H
+#include <span>
 #include <vector>
 
 #include "SortingAlgorithm.h"
 
 
+// Top-down merge sort; each merge copies the shorter run into one buffer of n/2 elements
+// allocated per sort() call. Instantiated for NullCounter and CountingCounter.
+template <class Counter = NullCounter>
 class MergeSort: public SortAlgorithm{
 
 public:
 
-    std::vector<int> sort(std::vector<int>& array);
+    SortStats sort(std::span<int> array) override;
 
 private:
 
-    bool COUNT_MERGE_COSTS = true;
-    long long totalMergeCosts = 0;
-    long long totalBufferCosts = 0;
+    Counter counter;
+    std::vector<int> buffer;
 
-    void merge(std::vector<int>& arr, int left, int mid, int right);
+    void merge_runs_copy_half(std::span<int> A, size_t l, size_t m, size_t r);
 
-    void merge_runs_copy_half(std::vector<int>& A, int l, int m, int r, std::vector<int>& B);
-
-    void merge_runs_basic(std::vector<int>& A, int l, int m, int r, std::vector<int>& B);
-
-    void merge_runs_basic_sentinels(std::vector<int>& A, int l, int m, int r, std::vector<int>& B);
-
-    void mergeSort(std::vector<int>& arr, int left, int right);
+    void mergeSort(std::span<int> A, size_t left, size_t right);
 
 };
 
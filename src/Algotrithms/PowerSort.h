@@ -1,90 +1,119 @@
-
-
 #ifndef POWERSORT_H
 #define POWERSORT_H
 #include <algorithm>
-#include <cassert>
-#include <cmath>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <thread>
+#include <utility>
 #include <vector>
-#include <stack>
-
 
+#include "GallopingMerge.h"
+#include "SortingAlgorithm.h"
+
+
+// Stable natural merge sort with Munro & Wild's power-based merge policy, over random-access
+// iterators with a comparator and a projection (the same interface as gfx::timsort).
+//
+// Runs are detected left to right (strictly descending runs are reversed, short runs are
+// extended to MIN_RUN by binary insertion), and every run boundary gets the power of its
+// node in the nearly-optimal merge tree; the run stack is merged down while its top has a
+// higher power. Merges go through GallopingMerge: the prefix and suffix already in place are
+// skipped, the shorter run is buffered, and galloping starts after MIN_GALLOP consecutive
+// wins of one side.
+//
+// sortParallel() splits the same work across threads: runs are detected per chunk and
+// joined where they continue across a chunk edge, the serial merge tree is built over the
+// resulting runs, independent subtrees are merged concurrently, and the largest merges are
+// cut into merge-path segments. The output is identical to sort()'s; the comparator and
+// projection must be safe to call from several threads.
+//
+// The merge buffers, the run stack and the parallel scratch array belong to the object and
+// are reused across calls.
+template <class T = int, class Counter = NullCounter>
 class PowerSort {
 
 public:
 
-const int minRunLen = 32;
+    static constexpr size_t MIN_RUN = 32;
+    static constexpr size_t MIN_GALLOP = GallopingMerge::MIN_GALLOP;
 
-    struct Run {
-        int start;
-        int end;
-    };
+    static constexpr size_t PARALLEL_MIN = size_t(1) << 16; // smaller inputs are sorted serially
+    static constexpr size_t MIN_CHUNK = size_t(1) << 13;    // run-detection chunk
+    static constexpr size_t MIN_TASK = size_t(1) << 14;     // smaller subtrees are merged by one thread
+    static constexpr size_t MIN_SEGMENT = size_t(1) << 14;  // merge-path segment
 
-    const Run NULL_RUN = {-1, -1};
+    using power_t = unsigned;
 
-    inline bool isNullRun(const Run& r) {
-        return r.start == -1 && r.end == -1;
+    template <std::random_access_iterator Iterator, std::sentinel_for<Iterator> Sentinel,
+              typename Compare = std::ranges::less, typename Projection = std::identity>
+        requires std::sortable<Iterator, Compare, Projection>
+              && std::same_as<std::iter_value_t<Iterator>, T>
+    SortStats sort(Iterator first, Sentinel last, Compare comp = {}, Projection proj = {}) {
+        counter = Counter{};
+        const auto lastIt = std::ranges::next(first, last);
+        const size_t n = static_cast<size_t>(lastIt - first);
+        if (n > 1) Pass<Iterator, Compare, Projection>{first, n, {comp, counter}, proj, counter, buffer}.run(runStack);
+        return counter.stats();
     }
 
-    inline unsigned floor_log2(size_t n) {
-        return (unsigned)std::floor(std::log2((double)n));
+    template <std::ranges::random_access_range Range,
+              typename Compare = std::ranges::less, typename Projection = std::identity>
+        requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+              && std::same_as<std::ranges::range_value_t<Range>, T>
+    SortStats sort(Range&& range, Compare comp = {}, Projection proj = {}) {
+        return sort(std::ranges::begin(range), std::ranges::end(range), comp, proj);
     }
 
-
-    int extend_and_reverse_run_right(std::vector<int>& A, int start, int right) {
-        int end = start;
-        if (start >= right) return start;
-
-        if (A[start + 1] < A[start]) {
-            while (end < right && A[end + 1] < A[end]) ++end;
-            std::reverse(A.begin() + start, A.begin() + end + 1);
-        } else {
-            while (end < right && A[end + 1] >= A[end]) ++end;
-        }
-        return end;
+    // sort() on up to `threads` threads; the counts are summed over the threads.
+    template <std::random_access_iterator Iterator, std::sentinel_for<Iterator> Sentinel,
+              typename Compare = std::ranges::less, typename Projection = std::identity>
+        requires std::sortable<Iterator, Compare, Projection>
+              && std::same_as<std::iter_value_t<Iterator>, T>
+    SortStats sortParallel(Iterator first, Sentinel last, unsigned threads = std::thread::hardware_concurrency(),
+                           Compare comp = {}, Projection proj = {}) {
+        const auto lastIt = std::ranges::next(first, last);
+        const size_t n = static_cast<size_t>(lastIt - first);
+        threads = static_cast<unsigned>(std::min<size_t>(threads, n / MIN_CHUNK));
+        if (threads <= 1 || n < PARALLEL_MIN) return sort(first, lastIt, comp, proj);
+
+        counter = Counter{};
+        Parallel<Iterator, Compare, Projection>(*this, first, n, threads, comp, proj).run();
+        return counter.stats();
     }
 
-
-    void insertionsort(std::vector<int>& A, int left, int right, int len) {
-        for (int i = left + 1; i <= right; i++) {
-            int key = A[i];
-            int j = i - 1;
-            while (j >= left && A[j] > key) {
-                A[j + 1] = A[j];
-                --j;
-            }
-            A[j + 1] = key;
-        }
+    template <std::ranges::random_access_range Range,
+              typename Compare = std::ranges::less, typename Projection = std::identity>
+        requires std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+              && std::same_as<std::ranges::range_value_t<Range>, T>
+    SortStats sortParallel(Range&& range, unsigned threads = std::thread::hardware_concurrency(),
+                           Compare comp = {}, Projection proj = {}) {
+        return sortParallel(std::ranges::begin(range), std::ranges::end(range), threads, comp, proj);
     }
-    void merge_runs(std::vector<int>& A, int left, int mid, int right, std::vector<int>& buffer) {
-        int n1 = mid - left;
-        buffer.resize(std::max<int>(buffer.size(), n1));
-
-        for (int i = 0; i < n1; i++) buffer[i] = A[left + i];
 
-        int i = 0, j = mid, k = left;
-        while (i < n1 && j < right) {
-            if (buffer[i] <= A[j]) {
-                A[k++] = buffer[i++];
-            } else {
-                A[k++] = A[j++];
-            }
-        }
-        while (i < n1) {
-            A[k++] = buffer[i++];
+    // Power of the boundary between runs [beginA, beginB) and [beginB, endB) of an array of
+    // length n: one plus the number of leading bits shared by the two run midpoints as
+    // fractions of n. Computed with one count-leading-zeros for n <= 2^31.
+    static power_t node_power(size_t n, size_t beginA, size_t beginB, size_t endB) {
+        const std::uint64_t l2 = beginA + beginB; // twice the midpoint of A
+        const std::uint64_t r2 = beginB + endB;   // twice the midpoint of B
+        if (n <= (size_t(1) << 31)) {
+            const auto a = static_cast<std::uint32_t>((l2 << 30) / n);
+            const auto b = static_cast<std::uint32_t>((r2 << 30) / n);
+            return static_cast<power_t>(std::countl_zero(a ^ b));
         }
+        return node_power_bitwise(n, l2, r2);
     }
 
-    using power_t = unsigned;
-
-    power_t node_power_bitwise(size_t begin, size_t end,
-                               size_t beginA, size_t beginB, size_t endB) {
-        size_t n = end - begin;
-        assert(n < (1ULL << 63));
-
-        size_t l = (beginA - begin) + (beginB - begin);
-        size_t r = (beginB - begin) + (endB - begin);
-
+    // Bit-by-bit reference for node_power, used above 2^31 elements.
+    static power_t node_power_bitwise(size_t n, std::uint64_t l, std::uint64_t r) {
         power_t nCommonBits = 0;
         bool digitA = l >= n, digitB = r >= n;
         while (digitA == digitB) {
@@ -100,57 +129,457 @@ const int minRunLen = 32;
         }
         return nCommonBits + 1;
     }
-    void power_sort(std::vector<int>& A, int left, int right) {
-        int n = right - left + 1;
-        unsigned lgnPlus2 = floor_log2(n) + 2;
 
-        std::vector<Run> runStack(lgnPlus2, NULL_RUN);
-        assert(isNullRun(runStack[0]) && isNullRun(runStack[lgnPlus2 - 1]));
-        unsigned top = 0;
+private:
+
+    struct Run {
+        size_t begin;
+        size_t end;
+        power_t power;
+    };
+
+    Counter counter;
+    std::vector<T> buffer;
+    std::vector<Run> runStack;
+    std::vector<std::vector<T>> workerBuffers; // merge buffer of each sortParallel() thread
+    std::vector<T> scratch;                    // output of merge-path segments
+
+    // Comparator that reports every call to the counter.
+    template <class Compare>
+    struct CountedLess {
+        Compare& comp;
+        Counter& counter;
+
+        template <class L, class R>
+        bool operator()(L&& l, R&& r) const {
+            counter.compare();
+            return std::invoke(comp, std::forward<L>(l), std::forward<R>(r));
+        }
+    };
 
-        std::vector<int> buffer(n / 2);
+    // Sorting state over a[0, n): one per sort() call, or one per thread of sortParallel().
+    template <class Iterator, class Compare, class Projection>
+    struct Pass {
+        Iterator a;
+        size_t n;
+        CountedLess<Compare> cmp;
+        Projection& proj;
+        Counter& counter;
+        std::vector<T>& buffer;
+
+        bool less(const T& x, const T& y) {
+            return cmp(std::invoke(proj, x), std::invoke(proj, y));
+        }
 
-        Run runA = {left, extend_and_reverse_run_right(A, left, right)};
-        int lenA = runA.end - runA.start + 1;
-        if (lenA < minRunLen) {
-            runA.end = std::min(right, runA.start + minRunLen - 1);
-            insertionsort(A, runA.start, runA.end, lenA);
+        void run(std::vector<Run>& stack) {
+            stack.clear();
+
+            size_t beginA = 0;
+            size_t endA = extendRun(0);
+            while (endA < n) {
+                const size_t endB = extendRun(endA);
+                const power_t p = node_power(n, beginA, endA, endB);
+                while (!stack.empty() && stack.back().power > p) {
+                    merge(stack.back().begin, stack.back().end, endA);
+                    beginA = stack.back().begin;
+                    stack.pop_back();
+                }
+                stack.push_back({beginA, endA, p});
+                beginA = endA;
+                endA = endB;
+            }
+            while (!stack.empty()) {
+                merge(stack.back().begin, stack.back().end, n);
+                stack.pop_back();
+            }
+        }
+
+        // End of the run starting at `begin`, reversed if strictly descending and extended
+        // to MIN_RUN elements (or the end of the array) by binary insertion.
+        size_t extendRun(size_t begin) {
+            bool descending;
+            const size_t end = scanRun(begin, n, descending);
+            if (descending) reverse(begin, end);
+            const size_t minEnd = std::max(end, std::min(n, begin + MIN_RUN));
+            insertTail(begin, end, minEnd);
+            return minEnd;
         }
 
-        while (runA.end < right) {
-            Run runB = {runA.end + 1, extend_and_reverse_run_right(A, runA.end + 1, right)};
-            int lenB = runB.end - runB.start + 1;
-            if (lenB < minRunLen) {
-                runB.end = std::min(right, runB.start + minRunLen - 1);
-                insertionsort(A, runB.start, runB.end, lenB);
+        // End of the longest run starting at `begin` within [begin, limit): non-descending,
+        // or strictly descending (then `descending` is set).
+        size_t scanRun(size_t begin, size_t limit, bool& descending) {
+            size_t end = begin + 1;
+            descending = false;
+            if (end < limit) {
+                if (less(a[end], a[end - 1])) {
+                    descending = true;
+                    while (end + 1 < limit && less(a[end + 1], a[end])) ++end;
+                } else {
+                    while (end + 1 < limit && !less(a[end + 1], a[end])) ++end;
+                }
+                ++end;
             }
+            return end;
+        }
 
-            unsigned k = node_power_bitwise(left, right + 1, runA.start, runB.start, runB.end);
-            assert(k != top);
+        void reverse(size_t begin, size_t end) {
+            std::reverse(a + begin, a + end);
+            counter.move(end - begin);
+        }
 
-            for (unsigned l = top; l > k; --l) {
-                if (isNullRun(runStack[l])) continue;
-                merge_runs(A, runStack[l].start, runStack[l].end + 1, runA.end + 1, buffer);
-                runA.start = runStack[l].start;
-                runStack[l] = NULL_RUN;
+        // Binary-inserts a[sorted, end) into the sorted [begin, sorted).
+        void insertTail(size_t begin, size_t sorted, size_t end) {
+            for (; sorted < end; ++sorted) {
+                T x = std::move(a[sorted]);
+                const Iterator pos = std::ranges::upper_bound(a + begin, a + sorted, std::invoke(proj, x), cmp, proj);
+                std::move_backward(pos, a + sorted, a + sorted + 1);
+                *pos = std::move(x);
+                counter.move(static_cast<std::uint64_t>(a + sorted - pos) + 1);
             }
+        }
+
+        // Comparator on elements, for GallopingMerge.
+        auto lessFn() {
+            return [this](const T& x, const T& y) { return less(x, y); };
+        }
+
+        // Merges the adjacent sorted runs [lo, mid) and [mid, hi).
+        void merge(size_t lo, size_t mid, size_t hi) {
+            counter.merge(hi - lo);
+            GallopingMerge::merge(a + lo, a + mid, a + hi, buffer, lessFn(), counter);
+        }
 
-            runStack[k] = runA;
-            top = k;
-            runA = runB;
+        // GallopingMerge::trim on offsets.
+        std::pair<size_t, size_t> trim(size_t lo, size_t mid, size_t hi) {
+            const auto [from, to] = GallopingMerge::trim(a + lo, a + mid, a + hi, lessFn());
+            return {static_cast<size_t>(from - a), static_cast<size_t>(to - a)};
         }
 
-        assert(runA.end == right);
-        for (unsigned l = top; l > 0; --l) {
-            if (!isNullRun(runStack[l])) {
-                merge_runs(A, runStack[l].start, runStack[l].end + 1, right + 1, buffer);
+        void mergeTrimmed(size_t lo, size_t mid, size_t hi) {
+            GallopingMerge::mergeTrimmed(a + lo, a + mid, a + hi, buffer, lessFn(), counter);
+        }
+
+        // Number of elements of [lo, mid) among the first k of the stable merge of [lo, mid)
+        // and [mid, hi): the smallest i with a[mid + k - i - 1] < a[lo + i].
+        size_t coRank(size_t k, size_t lo, size_t mid, size_t hi) {
+            size_t l = k > hi - mid ? k - (hi - mid) : 0;
+            size_t r = std::min(k, mid - lo);
+            while (l < r) {
+                const size_t i = l + (r - l) / 2;
+                if (less(a[mid + k - i - 1], a[lo + i])) r = i;
+                else l = i + 1;
             }
+            return l;
         }
-    }
+    };
 
-};
+    // State of one sortParallel() call over a[0, n).
+    template <class Iterator, class Compare, class Projection>
+    class Parallel {
+    public:
+        Parallel(PowerSort& self, Iterator a, size_t n, unsigned threads, Compare& comp, Projection& proj)
+            : self(self), a(a), n(n), threads(threads), comp(comp), proj(proj), counters(threads) {
+            if (self.workerBuffers.size() < threads) self.workerBuffers.resize(threads);
+        }
+
+        void run() {
+            const std::vector<std::pair<size_t, size_t>> runs = detectRuns();
+            buildTree(runs);
+            if (!nodes.empty()) mergeTree();
+            for (const Counter& c : counters) self.counter.add(c.stats());
+        }
+
+    private:
+        using Work = Pass<Iterator, Compare, Projection>;
+        static constexpr size_t NONE = size_t(-1);
+
+        struct Segment {
+            size_t begin;
+            size_t end;
+            bool descending;
+        };
+
+        // One detection chunk: inner runs are final, the edge runs wait for the join.
+        struct ChunkRuns {
+            Segment head{};
+            Segment tail{};
+            bool single = false; // the head reaches the chunk end; tail is unused
+            bool joined = false; // the head continues the previous chunk's last run
+            std::vector<std::pair<size_t, size_t>> inner;
+
+            Segment& last() { return single ? head : tail; }
+        };
+
+        // Merge of [lo, mid) and [mid, hi); children are node ids, NONE for a run.
+        struct Node {
+            size_t lo = 0, mid = 0, hi = 0;
+            size_t parent = NONE, left = NONE, right = NONE;
+            std::atomic<int> pending{0};       // child nodes not merged yet
+            std::atomic<size_t> remaining{0}; // unfinished pieces of a split merge
+        };
+
+        PowerSort& self;
+        Iterator a;
+        size_t n;
+        unsigned threads;
+        Compare& comp;
+        Projection& proj;
+        std::vector<Counter> counters; // one per thread
+        std::deque<Node> nodes;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void(unsigned)>> ready;
+        size_t queued = 0; // tasks pushed and not finished
+        std::exception_ptr error;
+
+        Work pass(unsigned t) {
+            return {a, n, {comp, counters[t]}, proj, counters[t], self.workerBuffers[t]};
+        }
+
+        // Runs of the whole array in order. Short runs are extended to MIN_RUN, except a run
+        // that ends at a chunk edge without joining the next chunk, which keeps its length.
+        std::vector<std::pair<size_t, size_t>> detectRuns() {
+            const size_t chunks = std::min<size_t>(size_t(4) * threads, n / MIN_CHUNK);
+            std::vector<ChunkRuns> parts(chunks);
+            forEach(chunks, [&](size_t c, unsigned t) {
+                Work p = pass(t);
+                const size_t limit = (c + 1) * n / chunks;
+                // a run reaching the chunk end, or a head of at least MIN_RUN, is kept as
+                // scanned for the join; any other run is made ascending and extended now
+                auto next = [&](size_t b, bool keepLong) {
+                    bool descending;
+                    const size_t e = p.scanRun(b, limit, descending);
+                    if (e == limit || (keepLong && e - b >= MIN_RUN)) return Segment{b, e, descending};
+                    if (descending) p.reverse(b, e);
+                    const size_t extended = std::max(e, std::min(limit, b + MIN_RUN));
+                    p.insertTail(b, e, extended);
+                    return Segment{b, extended, false};
+                };
+                ChunkRuns& part = parts[c];
+                part.head = next(c * n / chunks, true);
+                part.single = part.head.end == limit;
+                for (size_t b = part.head.end; b < limit;) {
+                    const Segment s = next(b, false);
+                    if (s.end == limit) part.tail = s;
+                    else part.inner.push_back({s.begin, s.end});
+                    b = s.end;
+                }
+            });
+
+            // a run that continues across a chunk edge is joined into the chunk it starts in
+            Work p = pass(0);
+            Segment* open = &parts[0].last();
+            for (size_t c = 1; c < chunks; ++c) {
+                const Segment& next = parts[c].head;
+                parts[c].joined = open->descending == next.descending
+                    && (open->descending ? p.less(a[next.begin], a[open->end - 1])
+                                         : !p.less(a[next.begin], a[open->end - 1]));
+                if (parts[c].joined) open->end = next.end;
+                if (!parts[c].joined || !parts[c].single) open = &parts[c].last();
+            }
+
+            std::vector<size_t> offset(chunks + 1, 0);
+            for (size_t c = 0; c < chunks; ++c) {
+                offset[c + 1] = offset[c] + !parts[c].joined + parts[c].inner.size() + !parts[c].single;
+            }
+            std::vector<std::pair<size_t, size_t>> all(offset[chunks]);
+            forEach(chunks, [&](size_t c, unsigned t) {
+                Work w = pass(t);
+                ChunkRuns& part = parts[c];
+                size_t o = offset[c];
+                auto edge = [&](const Segment& s) {
+                    if (s.descending) w.reverse(s.begin, s.end);
+                    all[o++] = {s.begin, s.end};
+                };
+                if (!part.joined) edge(part.head);
+                for (const auto& r : part.inner) all[o++] = r;
+                if (!part.single) edge(part.tail);
+                std::vector<std::pair<size_t, size_t>>().swap(part.inner);
+            });
+            return all;
+        }
+
+        size_t addNode(size_t lo, size_t mid, size_t hi, size_t left, size_t right) {
+            Node& node = nodes.emplace_back();
+            node.lo = lo;
+            node.mid = mid;
+            node.hi = hi;
+            node.left = left;
+            node.right = right;
+            const size_t id = nodes.size() - 1;
+            if (left != NONE) nodes[left].parent = id;
+            if (right != NONE) nodes[right].parent = id;
+            return id;
+        }
+
+        // The merges run() would do on these runs, as a tree.
+        void buildTree(const std::vector<std::pair<size_t, size_t>>& runs) {
+            struct Pending {
+                size_t begin;
+                size_t end;
+                power_t power;
+                size_t node;
+            };
+            std::vector<Pending> stack;
+            size_t beginA = runs[0].first, endA = runs[0].second, nodeA = NONE;
+            for (size_t r = 1; r < runs.size(); ++r) {
+                const size_t endB = runs[r].second;
+                const power_t p = node_power(n, beginA, endA, endB);
+                while (!stack.empty() && stack.back().power > p) {
+                    nodeA = addNode(stack.back().begin, stack.back().end, endA, stack.back().node, nodeA);
+                    beginA = stack.back().begin;
+                    stack.pop_back();
+                }
+                stack.push_back({beginA, endA, p, nodeA});
+                beginA = endA;
+                endA = endB;
+                nodeA = NONE;
+            }
+            while (!stack.empty()) {
+                nodeA = addNode(stack.back().begin, stack.back().end, n, stack.back().node, nodeA);
+                stack.pop_back();
+            }
+        }
+
+        // Subtrees up to `grain` elements are one task each; larger nodes are a task once
+        // both children are merged.
+        void mergeTree() {
+            const size_t grain = std::max(MIN_TASK, n / (size_t(8) * threads));
+            if (self.scratch.size() < n) self.scratch.resize(n);
+            for (size_t id = 0; id < nodes.size(); ++id) {
+                Node& node = nodes[id];
+                if (node.hi - node.lo <= grain) {
+                    if (node.parent == NONE || nodes[node.parent].hi - nodes[node.parent].lo > grain) {
+                        push([this, id](unsigned t) {
+                            Work w = pass(t);
+                            mergeSubtree(id, w);
+                            complete(id);
+                        });
+                    }
+                } else {
+                    node.pending = (node.left != NONE) + (node.right != NONE);
+                    if (node.pending == 0) push([this, id](unsigned t) { mergeNode(id, t); });
+                }
+            }
+
+            std::vector<std::thread> pool;
+            for (unsigned t = 1; t < threads; ++t) pool.emplace_back([this, t] { work(t); });
+            work(0);
+            for (auto& th : pool) th.join();
+            if (error) std::rethrow_exception(error);
+        }
+
+        void mergeSubtree(size_t id, Work& w) {
+            const Node& node = nodes[id];
+            if (node.left != NONE) mergeSubtree(node.left, w);
+            if (node.right != NONE) mergeSubtree(node.right, w);
+            w.merge(node.lo, node.mid, node.hi);
+        }
+
+        // Merges a large node, splitting it into merge-path segments written to scratch.
+        void mergeNode(size_t id, unsigned t) {
+            Node& node = nodes[id];
+            Work w = pass(t);
+            w.counter.merge(node.hi - node.lo);
+            const auto [from, to] = w.trim(node.lo, node.mid, node.hi);
+            const size_t pieces = std::min<size_t>(size_t(4) * threads, (to - from) / MIN_SEGMENT);
+            if (pieces <= 1) {
+                if (from < to) w.mergeTrimmed(from, node.mid, to);
+                complete(id);
+                return;
+            }
+
+            node.remaining = pieces;
+            for (size_t k = 0; k < pieces; ++k) {
+                push([this, id, k, pieces, from, to](unsigned t2) {
+                    Node& nd = nodes[id];
+                    Work p = pass(t2);
+                    const size_t k0 = (to - from) * k / pieces, k1 = (to - from) * (k + 1) / pieces;
+                    const size_t i0 = p.coRank(k0, from, nd.mid, to), i1 = p.coRank(k1, from, nd.mid, to);
+                    std::ranges::merge(std::make_move_iterator(a + from + i0), std::make_move_iterator(a + from + i1),
+                                       std::make_move_iterator(a + nd.mid + (k0 - i0)),
+                                       std::make_move_iterator(a + nd.mid + (k1 - i1)),
+                                       self.scratch.begin() + from + k0, p.cmp, proj, proj);
+                    p.counter.buffer(k1 - k0);
+                    if (nd.remaining.fetch_sub(1) == 1) copyBack(id, from, to, pieces);
+                });
+            }
+        }
 
+        // Moves a finished split merge from scratch back into the array, in `pieces` tasks.
+        void copyBack(size_t id, size_t from, size_t to, size_t pieces) {
+            nodes[id].remaining = pieces;
+            for (size_t k = 0; k < pieces; ++k) {
+                push([this, id, k, pieces, from, to](unsigned t) {
+                    const size_t b = from + (to - from) * k / pieces, e = from + (to - from) * (k + 1) / pieces;
+                    std::move(self.scratch.begin() + b, self.scratch.begin() + e, a + b);
+                    counters[t].move(e - b);
+                    if (nodes[id].remaining.fetch_sub(1) == 1) complete(id);
+                });
+            }
+        }
+
+        // Node `id` is merged; its parent becomes ready with its last child.
+        void complete(size_t id) {
+            const size_t parent = nodes[id].parent;
+            if (parent != NONE && nodes[parent].pending.fetch_sub(1) == 1) {
+                push([this, parent](unsigned t) { mergeNode(parent, t); });
+            }
+        }
 
+        void push(std::function<void(unsigned)> task) {
+            {
+                std::lock_guard lock(mutex);
+                ready.push_back(std::move(task));
+                ++queued;
+            }
+            cv.notify_one();
+        }
+
+        // Runs tasks on thread t until none are queued or running, or one has failed.
+        void work(unsigned t) {
+            std::unique_lock lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return !ready.empty() || queued == 0 || error; });
+                if (error || ready.empty()) return;
+                const std::function<void(unsigned)> task = std::move(ready.front());
+                ready.pop_front();
+
+                lock.unlock();
+                std::exception_ptr failure;
+                try {
+                    task(t);
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+                lock.lock();
+
+                if (failure && !error) error = failure;
+                if (--queued == 0 || error) cv.notify_all();
+            }
+        }
+
+        // body(i, t) for i in [0, count), strided over the threads.
+        template <class Body>
+        void forEach(size_t count, Body&& body) {
+            std::vector<std::exception_ptr> errors(threads);
+            auto worker = [&](unsigned t) {
+                try {
+                    for (size_t i = t; i < count; i += threads) body(i, t);
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            };
+            std::vector<std::thread> pool;
+            for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+            worker(0);
+            for (auto& th : pool) th.join();
+            for (auto& e : errors) if (e) std::rethrow_exception(e);
+        }
+    };
+
+};
 
 
 #endif //POWERSORT_H
@@ -2,55 +2,330 @@
 
 #include "QuickSort.h"
 
-#include <chrono>
-#include <iostream>
-#include <vector>
+#include <algorithm>
+#include <bit>
 
 
 
-int QuickSort::partition(std::vector<int>& array, int low, int high) {
-    int pivotIndex = (low + high) / 2;
-    int pivot = array[pivotIndex];
+template <class Counter>
+SortStats QuickSort<Counter>::sort(std::span<int> array) {
+    counter = Counter{};
+    if (array.size() > 1) {
+        const int badAllowed = static_cast<int>(std::bit_width(array.size())) - 1; // floor(log2(n))
+        quickSort(array.data(), array.data() + array.size(), badAllowed, true);
+    }
+    return counter.stats();
+}
+
+// Sorts [begin, end). Unless leftmost, begin[-1] is not greater than any element of the range.
+template <class Counter>
+void QuickSort<Counter>::quickSort(int* begin, int* end, int badAllowed, bool leftmost) {
+    while (true) {
+        const std::ptrdiff_t size = end - begin;
+        if (size < INSERTION_THRESHOLD) {
+            if (leftmost) insertionSort(begin, end);
+            else unguardedInsertionSort(begin, end);
+            return;
+        }
+
+        // pivot to *begin: the median of 3, or the ninther of 9 spread over the range
+        const std::ptrdiff_t half = size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            sort3(begin, begin + half, end - 1);
+            sort3(begin + 1, begin + (half - 1), end - 2);
+            sort3(begin + 2, begin + (half + 1), end - 3);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1));
+            swap(begin, begin + half);
+        } else {
+            sort3(begin + half, begin, end - 1);
+        }
 
-    std::swap(array[pivotIndex], array[high]);
-    swapCount++;
+        // the pivot equals the element before the range, so it is the smallest value here:
+        // the elements equal to it go left and are done
+        if (!leftmost && !less(begin[-1], *begin)) {
+            begin = partitionLeft(begin, end) + 1;
+            continue;
+        }
+
+        const auto [pivot, alreadyPartitioned] = partitionRight(begin, end);
+        const std::ptrdiff_t sizeL = pivot - begin;
+        const std::ptrdiff_t sizeR = end - (pivot + 1);
+
+        if (sizeL < size / 8 || sizeR < size / 8) {
+            if (--badAllowed == 0) {
+                heapSort(begin, end);
+                return;
+            }
+            // swap a few elements into the next pivot samples to break up the pattern
+            if (sizeL >= INSERTION_THRESHOLD) {
+                swap(begin, begin + sizeL / 4);
+                swap(pivot - 1, pivot - sizeL / 4);
+                if (sizeL > NINTHER_THRESHOLD) {
+                    swap(begin + 1, begin + (sizeL / 4 + 1));
+                    swap(begin + 2, begin + (sizeL / 4 + 2));
+                    swap(pivot - 2, pivot - (sizeL / 4 + 1));
+                    swap(pivot - 3, pivot - (sizeL / 4 + 2));
+                }
+            }
+            if (sizeR >= INSERTION_THRESHOLD) {
+                swap(pivot + 1, pivot + (1 + sizeR / 4));
+                swap(end - 1, end - sizeR / 4);
+                if (sizeR > NINTHER_THRESHOLD) {
+                    swap(pivot + 2, pivot + (2 + sizeR / 4));
+                    swap(pivot + 3, pivot + (3 + sizeR / 4));
+                    swap(end - 2, end - (1 + sizeR / 4));
+                    swap(end - 3, end - (2 + sizeR / 4));
+                }
+            }
+        } else if (alreadyPartitioned && partialInsertionSort(begin, pivot) && partialInsertionSort(pivot + 1, end)) {
+            // no element moved and both sides were (nearly) sorted
+            return;
+        }
 
-    int i = low;
-    for (int j = low; j < high; j++) {
-        if (array[j] <= pivot) {
-            std::swap(array[i], array[j]);
-            swapCount++;
-            i++;
+        // recurse into the smaller side, so the stack stays O(log n)
+        if (sizeL < sizeR) {
+            quickSort(begin, pivot, badAllowed, leftmost);
+            begin = pivot + 1;
+            leftmost = false;
+        } else {
+            quickSort(pivot + 1, end, badAllowed, false);
+            end = pivot;
         }
     }
+}
+
+// Partitions around *begin into [< pivot] pivot [>= pivot] and returns the pivot's position,
+// and whether the range was already partitioned. Elements on the wrong side are found a block
+// of BLOCK_SIZE at a time by recording their offsets without branching on the comparison.
+template <class Counter>
+std::pair<int*, bool> QuickSort<Counter>::partitionRight(int* begin, int* end) {
+    const int pivot = *begin;
+    int* first = begin;
+    int* last = end;
+
+    // the median-of-3 left an element not less than the pivot at end - 1
+    while (less(*++first, pivot)) {}
+    // no element before first means there may be none less than the pivot: guard the search
+    if (first - 1 == begin) {
+        while (first < last && !less(*--last, pivot)) {}
+    } else {
+        while (!less(*--last, pivot)) {}
+    }
+
+    const bool alreadyPartitioned = first >= last;
+    if (!alreadyPartitioned) {
+        swap(first, last);
+        ++first;
+
+        alignas(64) unsigned char offsetsL[BLOCK_SIZE];
+        alignas(64) unsigned char offsetsR[BLOCK_SIZE];
+        int* baseL = first;
+        int* baseR = last;
+        std::ptrdiff_t numL = 0, numR = 0, startL = 0, startR = 0;
+        while (first < last) {
+            // refill whichever offset block is empty from the unknown middle
+            const std::ptrdiff_t unknown = last - first;
+            const std::ptrdiff_t splitL = numL == 0 ? (numR == 0 ? unknown / 2 : unknown) : 0;
+            const std::ptrdiff_t splitR = numR == 0 ? unknown - splitL : 0;
+
+            const std::ptrdiff_t countL = std::min(splitL, BLOCK_SIZE);
+            for (std::ptrdiff_t i = 0; i < countL; ++i) {
+                offsetsL[numL] = static_cast<unsigned char>(i);
+                numL += !(*first < pivot);
+                ++first;
+            }
+            counter.compare(static_cast<std::uint64_t>(countL));
+            const std::ptrdiff_t countR = std::min(splitR, BLOCK_SIZE);
+            for (std::ptrdiff_t i = 0; i < countR;) {
+                offsetsR[numR] = static_cast<unsigned char>(++i);
+                numR += *--last < pivot;
+            }
+            counter.compare(static_cast<std::uint64_t>(countR));
+
+            const std::ptrdiff_t num = std::min(numL, numR);
+            swapOffsets(baseL, baseR, offsetsL + startL, offsetsR + startR, num, numL == numR);
+            numL -= num;
+            numR -= num;
+            startL += num;
+            startR += num;
+            if (numL == 0) {
+                startL = 0;
+                baseL = first;
+            }
+            if (numR == 0) {
+                startR = 0;
+                baseR = last;
+            }
+        }
 
-    std::swap(array[i], array[high]);
-    swapCount++;
+        // one block may still hold misplaced elements; move them to the boundary
+        if (numL) {
+            while (numL--) swap(baseL + offsetsL[startL + numL], --last);
+            first = last;
+        }
+        if (numR) {
+            while (numR--) swap(baseR - offsetsR[startR + numR], first), ++first;
+            last = first;
+        }
+    }
 
-    return i;
+    int* pivotPos = first - 1;
+    *begin = *pivotPos;
+    *pivotPos = pivot;
+    counter.move(2);
+    return {pivotPos, alreadyPartitioned};
 }
 
-void QuickSort::quickSort(std::vector<int>& array, int low, int high) {
-    if (low < high) {
-        int pivotIndex = partition(array, low, high);
-        quickSort(array, low, pivotIndex - 1);
-        quickSort(array, pivotIndex + 1, high);
+// Exchanges num misplaced left elements with num misplaced right ones, as a cycle of moves
+// unless the blocks were equally full (then pairwise swaps keep descending input linear).
+template <class Counter>
+void QuickSort<Counter>::swapOffsets(int* first, int* last, const unsigned char* offsetsL,
+                                     const unsigned char* offsetsR, std::ptrdiff_t num, bool useSwaps) {
+    if (useSwaps) {
+        for (std::ptrdiff_t i = 0; i < num; ++i) std::swap(first[offsetsL[i]], *(last - offsetsR[i]));
+    } else if (num > 0) {
+        int* l = first + offsetsL[0];
+        int* r = last - offsetsR[0];
+        const int tmp = *l;
+        *l = *r;
+        for (std::ptrdiff_t i = 1; i < num; ++i) {
+            l = first + offsetsL[i];
+            *r = *l;
+            r = last - offsetsR[i];
+            *l = *r;
+        }
+        *r = tmp;
     }
+    counter.move(static_cast<std::uint64_t>(2 * num));
 }
 
-std::vector<int> QuickSort::sort(std::vector<int>& array) {
-    std::vector<int> arr = array;
-    swapCount = 0;
+// Partitions around *begin into [<= pivot] pivot [> pivot] and returns the pivot's position.
+// Only used when no element of the range is less than the pivot, so the left side holds
+// exactly the elements equal to it.
+template <class Counter>
+int* QuickSort<Counter>::partitionLeft(int* begin, int* end) {
+    const int pivot = *begin;
+    int* first = begin;
+    int* last = end;
 
-    auto start = std::chrono::high_resolution_clock::now();
+    while (less(pivot, *--last)) {}
+    if (last + 1 == end) {
+        while (first < last && !less(pivot, *++first)) {}
+    } else {
+        while (!less(pivot, *++first)) {}
+    }
 
-    quickSort(arr, 0, arr.size() - 1);
+    while (first < last) {
+        swap(first, last);
+        while (less(pivot, *--last)) {}
+        while (!less(pivot, *++first)) {}
+    }
+
+    *begin = *last;
+    *last = pivot;
+    counter.move(2);
+    return last;
+}
+
+template <class Counter>
+void QuickSort<Counter>::sort2(int* a, int* b) {
+    if (less(*b, *a)) swap(a, b);
+}
+
+template <class Counter>
+void QuickSort<Counter>::sort3(int* a, int* b, int* c) {
+    sort2(a, b);
+    sort2(b, c);
+    sort2(a, b);
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> runtime = end - start;
+template <class Counter>
+void QuickSort<Counter>::insertionSort(int* begin, int* end) {
+    if (begin == end) return;
+    for (int* cur = begin + 1; cur != end; ++cur) {
+        int* sift = cur;
+        if (less(*sift, sift[-1])) {
+            const int x = *sift;
+            do {
+                *sift = sift[-1];
+                --sift;
+                counter.move();
+            } while (sift != begin && less(x, sift[-1]));
+            *sift = x;
+            counter.move();
+        }
+    }
+}
 
-    std::cout << "Swaps: " << swapCount << std::endl;
-    std::cout << "Runtime: " << runtime.count() << " seconds" << std::endl;
+// Insertion sort without the lower bound check: begin[-1] stops every shift.
+template <class Counter>
+void QuickSort<Counter>::unguardedInsertionSort(int* begin, int* end) {
+    if (begin == end) return;
+    for (int* cur = begin + 1; cur != end; ++cur) {
+        int* sift = cur;
+        if (less(*sift, sift[-1])) {
+            const int x = *sift;
+            do {
+                *sift = sift[-1];
+                --sift;
+                counter.move();
+            } while (less(x, sift[-1]));
+            *sift = x;
+            counter.move();
+        }
+    }
+}
+
+// Insertion sort that gives up (returning false) once more than PARTIAL_INSERTION_LIMIT
+// elements have been shifted.
+template <class Counter>
+bool QuickSort<Counter>::partialInsertionSort(int* begin, int* end) {
+    if (begin == end) return true;
+    std::ptrdiff_t shifted = 0;
+    for (int* cur = begin + 1; cur != end; ++cur) {
+        int* sift = cur;
+        if (less(*sift, sift[-1])) {
+            const int x = *sift;
+            do {
+                *sift = sift[-1];
+                --sift;
+                counter.move();
+            } while (sift != begin && less(x, sift[-1]));
+            *sift = x;
+            counter.move();
+            shifted += cur - sift;
+        }
+        if (shifted > PARTIAL_INSERTION_LIMIT) return false;
+    }
+    return true;
+}
+
+template <class Counter>
+void QuickSort<Counter>::heapSort(int* begin, int* end) {
+    const std::ptrdiff_t size = end - begin;
+    for (std::ptrdiff_t i = size / 2; i-- > 0;) siftDown(begin, size, i);
+    for (std::ptrdiff_t i = size - 1; i > 0; --i) {
+        swap(begin, begin + i);
+        siftDown(begin, i, 0);
+    }
+}
+
+// Restores the max-heap property below `root` in heap[0, size).
+template <class Counter>
+void QuickSort<Counter>::siftDown(int* heap, std::ptrdiff_t size, std::ptrdiff_t root) {
+    const int x = heap[root];
+    while (true) {
+        std::ptrdiff_t child = 2 * root + 1;
+        if (child >= size) break;
+        if (child + 1 < size && less(heap[child], heap[child + 1])) ++child;
+        if (!less(x, heap[child])) break;
+        heap[root] = heap[child];
+        counter.move();
+        root = child;
+    }
+    heap[root] = x;
+    counter.move();
+}
 
-    return arr;
-}
\ No newline at end of file
+template class QuickSort<NullCounter>;
+template class QuickSort<CountingCounter>;
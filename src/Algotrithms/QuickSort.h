@@ -1,20 +1,56 @@
-
-
 #ifndef QUICKSORT_H
 #define QUICKSORT_H
-#include <vector>
+#include <cstddef>
+#include <span>
+#include <utility>
 
 #include "SortingAlgorithm.h"
 
 
+// Pattern-defeating quicksort (Peters' pdqsort) on int: median-of-3 pivots, ninthers above
+// NINTHER_THRESHOLD, branchless block partitioning, and a partition that groups the elements
+// equal to the pivot when the pivot equals its predecessor, so duplicates are finished in
+// one pass. Partitions below INSERTION_THRESHOLD are insertion sorted; a partition that was
+// already in order is finished by a bounded insertion sort; after log2(n) badly unbalanced
+// partitions the range is heapsorted. Unstable; recursion goes into the smaller side.
+template <class Counter = NullCounter>
 class QuickSort: public SortAlgorithm {
 
 public:
-    std::vector<int> sort(std::vector<int>& array);
+    static constexpr std::ptrdiff_t INSERTION_THRESHOLD = 24;
+    static constexpr std::ptrdiff_t NINTHER_THRESHOLD = 128;
+    static constexpr std::ptrdiff_t PARTIAL_INSERTION_LIMIT = 8;
+    static constexpr std::ptrdiff_t BLOCK_SIZE = 64;
+
+    SortStats sort(std::span<int> array) override;
 
 private:
-    void quickSort(std::vector<int>& array, int low, int high);
-    int partition(std::vector<int>& array, int low, int high);
+    Counter counter;
+
+    bool less(int x, int y) {
+        counter.compare();
+        return x < y;
+    }
+
+    void swap(int* x, int* y) {
+        std::swap(*x, *y);
+        counter.move(2);
+    }
+
+    void quickSort(int* begin, int* end, int badAllowed, bool leftmost);
+
+    std::pair<int*, bool> partitionRight(int* begin, int* end);
+    int* partitionLeft(int* begin, int* end);
+    void swapOffsets(int* first, int* last, const unsigned char* offsetsL, const unsigned char* offsetsR,
+                     std::ptrdiff_t num, bool useSwaps);
+
+    void sort2(int* a, int* b);
+    void sort3(int* a, int* b, int* c);
+    void insertionSort(int* begin, int* end);
+    void unguardedInsertionSort(int* begin, int* end);
+    bool partialInsertionSort(int* begin, int* end);
+    void heapSort(int* begin, int* end);
+    void siftDown(int* heap, std::ptrdiff_t size, std::ptrdiff_t root);
 
 };
 
@@ -1,26 +1,61 @@
 
+
 #ifndef SORTINGALGORITHM_H
 #define SORTINGALGORITHM_H
-#include <iostream>
+#include <cstdint>
 #include <ostream>
+#include <span>
 
-class SortAlgorithm {
-protected:
-    int swapCount = 0;
-    int compareCount = 0;
-    double runtime = 0.0;
+// What one sort() call did, as recorded by its counter policy.
+struct SortStats {
+    std::uint64_t comparisons = 0;
+    std::uint64_t moves = 0;         // element writes into the array (a swap is two)
+    std::uint64_t mergeCost = 0;     // summed lengths of the runs merged
+    std::uint64_t bufferTraffic = 0; // element writes into scratch buffers
+};
 
-public:
-    virtual std::vector<int> sort(std::vector<int>& array) = 0;
+// Counter policies. Algorithms report every comparison, move and merge to their Counter;
+// NullCounter's hooks are empty and inline away, so Sort<NullCounter> is the production
+// path and Sort<CountingCounter> the instrumented one.
+struct NullCounter {
+    void compare(std::uint64_t = 1) {}
+    void move(std::uint64_t = 1) {}
+    void merge(std::uint64_t) {}
+    void buffer(std::uint64_t) {}
+    void add(const SortStats&) {}
+    SortStats stats() const { return {}; }
+};
 
-    virtual void printStats() {
-        std::cout << "swap count: " << swapCount << std::endl;
-        std::cout << "compare count: " << compareCount << std::endl;
-        std::cout << "runtime: " << runtime << std::endl;
+struct CountingCounter {
+    void compare(std::uint64_t n = 1) { s.comparisons += n; }
+    void move(std::uint64_t n = 1) { s.moves += n; }
+    void merge(std::uint64_t n) { s.mergeCost += n; }
+    void buffer(std::uint64_t n) { s.bufferTraffic += n; }
+    void add(const SortStats& o) {
+        s.comparisons += o.comparisons;
+        s.moves += o.moves;
+        s.mergeCost += o.mergeCost;
+        s.bufferTraffic += o.bufferTraffic;
     }
+    SortStats stats() const { return s; }
 
+private:
+    SortStats s;
+};
+
+class SortAlgorithm {
+public:
+    // Sorts `array` ascending in place.
+    virtual SortStats sort(std::span<int> array) = 0;
 
     virtual ~SortAlgorithm() {}
 };
 
+inline std::ostream& operator<<(std::ostream& os, const SortStats& s) {
+    return os << "comparisons: " << s.comparisons << "\n"
+              << "moves: " << s.moves << "\n"
+              << "merge costs: " << s.mergeCost << "\n"
+              << "buffer costs: " << s.bufferTraffic << "\n";
+}
+
 #endif //SORTINGALGORITHM_H
@@ -0,0 +1,159 @@
+
+
+#ifndef ADAPTIVESAMPLER_H
+#define ADAPTIVESAMPLER_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Estimator.h"
+#include "Metric.h"
+#include "../Data/SamplingStrategy.h"
+
+
+// Sequential sampling: grows one sample in rounds (stratified picks or whole clusters)
+// until the bootstrap standard error of every chosen metric (Estimator::estimable; Runs/Osc
+// need CLUSTER) is at most the target, or the budget is spent. Positions drawn in earlier
+// rounds are kept; each round only adds new ones, so cost tracks how hard the array is
+// rather than a worst-case fixed size.
+class AdaptiveSampler {
+
+public:
+    struct Config {
+        SamplingStrategy strategy = SamplingStrategy::STRATIFIED; // STRATIFIED or CLUSTER
+        int initialSize = 100;
+        int budget = 10000;
+        double growth = 2.0;              // sample size multiplier per round
+        double targetStdError = 0.01;
+        std::vector<Metric> metrics{Metric::Inversions};
+        int clusterSize = 10;             // CLUSTER steps only
+        int bootstrapRounds = 200;
+    };
+
+    struct Result {
+        std::vector<int> sample;
+        std::vector<int> indices;         // increasing array positions
+        Estimator::DisorderEstimate estimate;
+        int rounds = 0;
+        bool converged = false;
+    };
+
+    AdaptiveSampler(const std::vector<int>& array, Config cfg)
+        : AdaptiveSampler(array, std::move(cfg), std::random_device{}()) {}
+
+    AdaptiveSampler(const std::vector<int>& array, Config cfg, std::uint32_t seed)
+        : arr(array), cfg(std::move(cfg)), gen(seed),
+          estimator(this->cfg.strategy, this->cfg.bootstrapRounds, 0.95, seed ^ 0x9e3779b9u) {
+        for (Metric m : this->cfg.metrics) {
+            if (!Estimator::estimable(m, this->cfg.strategy)) {
+                throw std::invalid_argument("AdaptiveSampler: metric has no estimator for this strategy");
+            }
+        }
+    }
+
+    Result run() {
+        Result res;
+        const int n = static_cast<int>(arr.size());
+        const int budget = std::min(cfg.budget, n);
+        if (n == 0 || budget <= 0) return res;
+
+        int target = std::max(1, std::min(cfg.initialSize, budget));
+
+        while (true) {
+            const int need = target - static_cast<int>(res.indices.size());
+            std::vector<int> fresh = (cfg.strategy == SamplingStrategy::CLUSTER)
+                                         ? drawClusters(need, res.indices)
+                                         : drawStratified(need, res.indices);
+            const size_t mid = res.indices.size();
+            res.indices.insert(res.indices.end(), fresh.begin(), fresh.end());
+            std::inplace_merge(res.indices.begin(), res.indices.begin() + mid, res.indices.end());
+            ++res.rounds;
+
+            res.sample.clear();
+            res.sample.reserve(res.indices.size());
+            for (int idx : res.indices) res.sample.push_back(arr[idx]);
+            res.estimate = estimator.estimate(res.sample, res.indices);
+
+            res.converged = precise(res.estimate);
+            if (res.converged || (int)res.indices.size() >= budget || fresh.empty()) break;
+
+            target = std::min(budget, std::max(target + 1,
+                              static_cast<int>(std::ceil(target * cfg.growth))));
+        }
+        return res;
+    }
+
+private:
+    const std::vector<int>& arr;
+    Config cfg;
+    std::mt19937 gen;
+    Estimator estimator;
+
+    bool precise(const Estimator::DisorderEstimate& e) const {
+        for (Metric m : cfg.metrics) {
+            if (e[m].stdError > cfg.targetStdError) return false;
+        }
+        return true;
+    }
+
+    // Positions of the sorted `taken` in [lo, hi).
+    static std::pair<std::vector<int>::const_iterator, std::vector<int>::const_iterator>
+    takenIn(const std::vector<int>& taken, int lo, int hi) {
+        return {std::lower_bound(taken.begin(), taken.end(), lo),
+                std::lower_bound(taken.begin(), taken.end(), hi)};
+    }
+
+    // One new position per equal-width stratum, uniform among the stratum's free positions
+    // (`taken`, sorted, holds the earlier rounds). Strata are redrawn each round so that the
+    // union over rounds stays spread across the whole array. Returned sorted.
+    std::vector<int> drawStratified(int count, const std::vector<int>& taken) {
+        std::vector<int> out;
+        const int n = static_cast<int>(arr.size());
+        if (count <= 0) return out;
+
+        for (int s = 0; s < count; ++s) {
+            const int lo = static_cast<int>(static_cast<long long>(s) * n / count);
+            const int hi = static_cast<int>(static_cast<long long>(s + 1) * n / count);
+            const auto [first, last] = takenIn(taken, lo, hi);
+            const int free = (hi - lo) - static_cast<int>(last - first);
+            if (free <= 0) continue;
+
+            // the r-th free position: step past every taken one at or before it
+            int idx = lo + std::uniform_int_distribution<int>(0, free - 1)(gen);
+            for (auto it = first; it != last && *it <= idx; ++it) ++idx;
+            out.push_back(idx);
+        }
+        return out;
+    }
+
+    // Whole clusters at random free positions; at most `count` new positions, returned sorted.
+    std::vector<int> drawClusters(int count, const std::vector<int>& taken) {
+        std::vector<int> out;
+        const int n = static_cast<int>(arr.size());
+        const int len = std::max(1, std::min(cfg.clusterSize, n));
+        if (count <= 0) return out;
+
+        std::uniform_int_distribution<int> dis(0, n - len);
+        int misses = 0;
+        while ((int)out.size() < count && misses < 64) {
+            const int start = dis(gen);
+            const int end = start + std::min(len, count - static_cast<int>(out.size()));
+            const auto [first, last] = takenIn(taken, start, end);
+            const auto [outFirst, outLast] = takenIn(out, start, end);
+            if (first != last || outFirst != outLast) {
+                ++misses;
+                continue;
+            }
+            const auto at = out.insert(outFirst, end - start, 0);
+            std::iota(at, at + (end - start), start);
+        }
+        return out;
+    }
+};
+
+#endif //ADAPTIVESAMPLER_H
@@ -0,0 +1,181 @@
+#include "Estimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+Estimator::Estimator(SamplingStrategy strategy, int bootstrapRounds, double confidence)
+    : Estimator(strategy, bootstrapRounds, confidence, std::random_device{}())
+{}
+
+Estimator::Estimator(SamplingStrategy strategy, int bootstrapRounds, double confidence, std::uint32_t seed)
+    : strategy(strategy), bootstrapRounds(bootstrapRounds), confidence(confidence), gen(seed)
+{}
+
+bool Estimator::clustered() const {
+    return strategy == SamplingStrategy::CLUSTER || strategy == SamplingStrategy::COMBINED;
+}
+
+std::vector<int> Estimator::splitUnits(const std::vector<int>& indices, int sampleSize) {
+    std::vector<int> lengths;
+    if (sampleSize <= 0) return lengths;
+    if ((int)indices.size() != sampleSize) {
+        lengths.assign(sampleSize, 1);
+        return lengths;
+    }
+
+    int len = 1;
+    for (int k = 1; k < sampleSize; ++k) {
+        if (indices[k] == indices[k - 1] + 1) {
+            ++len;
+        } else {
+            lengths.push_back(len);
+            len = 1;
+        }
+    }
+    lengths.push_back(len);
+    return lengths;
+}
+
+double Estimator::crossUnitInversionRate(const std::vector<int>& sample, const std::vector<int>& unitLengths) {
+    const long long m = static_cast<long long>(sample.size());
+    long long inv = dm.calculateInversions(sample);
+    long long pairs = m * (m - 1) / 2;
+
+    size_t cursor = 0;
+    for (int len : unitLengths) {
+        const std::vector<int> unit(sample.begin() + cursor, sample.begin() + cursor + len);
+        inv   -= dm.calculateInversions(unit);
+        pairs -= static_cast<long long>(len) * (len - 1) / 2;
+        cursor += len;
+    }
+
+    if (pairs <= 0) return dm.normalizeInversions(dm.calculateInversions(sample), m);
+    return static_cast<double>(inv) / static_cast<double>(pairs);
+}
+
+double Estimator::adjacentDescentRate(const std::vector<int>& sample, const std::vector<int>& unitLengths) {
+    long long descents = 0;
+    long long pairs = 0;
+
+    size_t start = 0;
+    for (int len : unitLengths) {
+        for (size_t k = start + 1; k < start + len; ++k) {
+            ++pairs;
+            if (sample[k] < sample[k - 1]) ++descents;
+        }
+        start += len;
+    }
+
+    if (pairs == 0) return std::numeric_limits<double>::quiet_NaN();
+    return static_cast<double>(descents) / static_cast<double>(pairs);
+}
+
+double Estimator::adjacentOscRate(const std::vector<int>& sample, const std::vector<int>& unitLengths) {
+    long long turns = 0;
+    long long triples = 0;
+
+    size_t start = 0;
+    for (int len : unitLengths) {
+        for (size_t k = start + 1; k + 1 < start + len; ++k) {
+            ++triples;
+            const bool isPeak   = sample[k - 1] < sample[k] && sample[k] > sample[k + 1];
+            const bool isValley = sample[k - 1] > sample[k] && sample[k] < sample[k + 1];
+            if (isPeak || isValley) ++turns;
+        }
+        start += len;
+    }
+
+    if (triples == 0) return std::numeric_limits<double>::quiet_NaN();
+    return static_cast<double>(turns) / static_cast<double>(triples);
+}
+
+std::array<double, 6> Estimator::pointEstimate(const std::vector<int>& sample, const std::vector<int>& unitLengths) {
+    std::array<double, 6> out;
+    out.fill(std::numeric_limits<double>::quiet_NaN());
+    const long long m = static_cast<long long>(sample.size());
+    if (m == 0) {
+        out[static_cast<int>(Metric::Inversions)] = 0.0;
+        return out;
+    }
+
+    out[static_cast<int>(Metric::Inversions)] =
+        clustered() ? crossUnitInversionRate(sample, unitLengths)
+                    : dm.normalizeInversions(dm.calculateInversions(sample), m);
+    if (clustered()) {
+        out[static_cast<int>(Metric::Runs)] = adjacentDescentRate(sample, unitLengths);
+        out[static_cast<int>(Metric::Osc)]  = adjacentOscRate(sample, unitLengths);
+    }
+    return out;
+}
+
+Estimator::DisorderEstimate Estimator::estimate(const std::vector<int>& sample, const std::vector<int>& indices) {
+    DisorderEstimate result;
+    const int m = static_cast<int>(sample.size());
+    const std::vector<int> units = splitUnits(indices, m);
+
+    const auto point = pointEstimate(sample, units);
+    for (size_t i = 0; i < point.size(); ++i) {
+        result.byMetric[i] = {point[i], std::isnan(point[i]) ? point[i] : 0.0, point[i], point[i]};
+    }
+    if (units.size() < 2 || bootstrapRounds <= 0) return result;
+
+    std::vector<int> unitStarts(units.size(), 0);
+    for (size_t u = 1; u < units.size(); ++u) unitStarts[u] = unitStarts[u - 1] + units[u - 1];
+
+    // Resampled units are reassembled in original order so order-based metrics stay meaningful.
+    std::vector<std::array<double, 6>> replicas;
+    replicas.reserve(bootstrapRounds);
+    std::uniform_int_distribution<int> pickUnit(0, static_cast<int>(units.size()) - 1);
+    std::vector<int> chosen(units.size());
+    std::vector<int> resample;
+    std::vector<int> resampleUnits;
+
+    for (int b = 0; b < bootstrapRounds; ++b) {
+        for (auto& c : chosen) c = pickUnit(gen);
+        std::sort(chosen.begin(), chosen.end());
+
+        resample.clear();
+        resampleUnits.clear();
+        for (int u : chosen) {
+            resample.insert(resample.end(),
+                            sample.begin() + unitStarts[u],
+                            sample.begin() + unitStarts[u] + units[u]);
+            resampleUnits.push_back(units[u]);
+        }
+        replicas.push_back(pointEstimate(resample, resampleUnits));
+    }
+
+    const double alpha = (1.0 - confidence) / 2.0;
+    std::vector<double> column;
+    for (size_t i = 0; i < point.size(); ++i) {
+        if (std::isnan(point[i])) continue;
+        // a replica can lose every adjacent pair (Runs/Osc); it has no value to contribute
+        column.clear();
+        double mean = 0.0;
+        for (const auto& r : replicas) {
+            if (std::isnan(r[i])) continue;
+            column.push_back(r[i]);
+            mean += r[i];
+        }
+        if (column.empty()) continue;
+        mean /= static_cast<double>(column.size());
+
+        double var = 0.0;
+        for (double v : column) var += (v - mean) * (v - mean);
+        var /= static_cast<double>(std::max<size_t>(1, column.size() - 1));
+
+        std::sort(column.begin(), column.end());
+        const auto at = [&](double q) {
+            const size_t k = static_cast<size_t>(std::floor(q * (column.size() - 1) + 0.5));
+            return column[std::min(k, column.size() - 1)];
+        };
+
+        Estimate& e = result.byMetric[i];
+        e.stdError = std::sqrt(var);
+        e.lo = at(alpha);
+        e.hi = at(1.0 - alpha);
+    }
+    return result;
+}
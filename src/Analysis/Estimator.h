@@ -0,0 +1,88 @@
+
+
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "DisorderMetrics.h"
+#include "Metric.h"
+#include "../Data/SamplingStrategy.h"
+
+
+// Turns one sample's metrics into estimates of the full array's normalized metrics.
+//
+// Sample elements are grouped into units: maximal blocks of consecutive array positions
+// (a cluster, or a single element for stratified picks). Per-metric corrections:
+//  - Inversions: for CLUSTER/COMBINED only pairs from different units are counted, since
+//    within-cluster pairs are neighbours in the array and not representative of all pairs.
+//  - Runs/Osc: CLUSTER/COMBINED only, measured on sample pairs/triples that are adjacent in
+//    the array; NaN when the sample has none (or no positions are known). Stratified and
+//    simple samples are NaN: their neighbours lie far apart in the array, so an array of
+//    many short sorted runs samples like a random one.
+//  - Rem/Dis/Ham: not estimated (NaN). A sample's own values do not estimate them: the LIS
+//    of m elements sampled from a random permutation is ~2*sqrt(m), so Rem/m is off from Rem/n
+//    by a factor depending on n/m and the array; Dis and Ham are positional in the same way.
+// Confidence intervals come from a bootstrap over units (percentile method), so clustered
+// samples are resampled cluster by cluster when their positions are known.
+class Estimator {
+public:
+    struct Estimate {
+        double value = 0.0;
+        double stdError = 0.0;
+        double lo = 0.0;
+        double hi = 0.0;
+    };
+
+    struct DisorderEstimate {
+        std::array<Estimate, 6> byMetric;
+
+        const Estimate& operator[](Metric m) const { return byMetric[static_cast<int>(m)]; }
+        Estimate& operator[](Metric m) { return byMetric[static_cast<int>(m)]; }
+    };
+
+    explicit Estimator(SamplingStrategy strategy,
+                       int bootstrapRounds = 200,
+                       double confidence = 0.95);
+
+    Estimator(SamplingStrategy strategy, int bootstrapRounds, double confidence, std::uint32_t seed);
+
+    // `indices` are the array positions of the sample elements (same order as `sample`);
+    // pass an empty vector when they are unknown.
+    DisorderEstimate estimate(const std::vector<int>& sample, const std::vector<int>& indices);
+
+    // Point estimates for the given unit split, without confidence intervals.
+    std::array<double, 6> pointEstimate(const std::vector<int>& sample, const std::vector<int>& unitLengths);
+
+    static std::vector<int> splitUnits(const std::vector<int>& indices, int sampleSize);
+
+    // Inversions, Runs and Osc; the other metrics are NaN in every estimate.
+    static bool estimable(Metric m) {
+        return m == Metric::Inversions || m == Metric::Runs || m == Metric::Osc;
+    }
+
+    // Whether samples drawn with `strategy` estimate `m`: Runs/Osc need clustered samples.
+    static bool estimable(Metric m, SamplingStrategy strategy) {
+        if (m == Metric::Runs || m == Metric::Osc) {
+            return strategy == SamplingStrategy::CLUSTER || strategy == SamplingStrategy::COMBINED;
+        }
+        return estimable(m);
+    }
+
+private:
+    SamplingStrategy strategy;
+    int bootstrapRounds;
+    double confidence;
+    std::mt19937 gen;
+    DisorderMetrics dm;
+
+    bool clustered() const;
+
+    double crossUnitInversionRate(const std::vector<int>& sample, const std::vector<int>& unitLengths);
+    double adjacentDescentRate(const std::vector<int>& sample, const std::vector<int>& unitLengths);
+    double adjacentOscRate(const std::vector<int>& sample, const std::vector<int>& unitLengths);
+};
+
+#endif //ESTIMATOR_H
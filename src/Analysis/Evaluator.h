@@ -2,11 +2,21 @@
 
 #ifndef CHARTBUILDER_H
 #define CHARTBUILDER_H
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <numeric>
 #include <vector>
+#include "AdaptiveSampler.h"
 #include "DisorderMetrics.h"
+#include "Estimator.h"
+#include "Metric.h"
 
+#include "../Data/SampleCodec.h"
+#include "../Data/SamplePyramid.h"
 #include "../Data/Sampler.h"
 
 #include <iostream>
@@ -15,6 +25,7 @@
 #include <stdexcept>
 
 #include <system_error>
+#include <thread>
 
 
 namespace fs = std::filesystem;
@@ -38,7 +49,7 @@ public:
                 const fs::path outDir  = fs::path(outputRoot) / rel;
                 ensureDir(outDir.string());
 
-                if (hasFile(entry.path(), "samples.csv")) {
+                if (hasFile(entry.path(), "samples.csv") || hasFile(entry.path(), "samples.idx")) {
                     const fs::path sampleMetrics = outDir / "sample_metrics.csv";
                     createFileIfNotExists(sampleMetrics.string());
                 }
@@ -53,10 +64,15 @@ public:
         std::cout << "[OK] Prepared output structure at: " << outputRoot << "\n";
     }
 
+    // evaluateArrays = false skips the full-array arrays_metrics.csv pass (see estimateAll).
+    // A non-empty `metrics` restricts the columns (and the work) to those metrics.
     void evaluateAll(const std::string& inputRoot,
                  const std::string& outputRoot,
-                 bool overwrite) const
+                 bool overwrite,
+                 bool evaluateArrays = true,
+                 const std::vector<Metric>& metrics = {}) const
 {
+    const MetricMask wanted = metricMask(metrics);
     if (!fs::exists(inputRoot)) {
         throw std::runtime_error("Input root does not exist: " + inputRoot);
     }
@@ -67,6 +83,7 @@ public:
         const fs::path out = fs::path(outputRoot) / rel;
 
         if (entry.is_regular_file() && entry.path().filename() == "arrays.csv") {
+            if (!evaluateArrays) continue;
             const fs::path outDir         = out.parent_path();
             const fs::path arraysMetrics  = outDir / "arrays_metrics.csv";
             ensureDir(outDir.string());
@@ -78,7 +95,7 @@ public:
                 std::cout << "[WRITE] " << arraysMetrics.string()
                           << (overwrite ? " (overwrite)\n" : " (create)\n");
                 evaluateCSVtoNormMetrics(entry.path().string(),
-                                         arraysMetrics.string());
+                                         arraysMetrics.string(), wanted);
             }
             continue;
         }
@@ -96,7 +113,27 @@ public:
                 std::cout << "[WRITE] " << sampleMetrics.string()
                           << (overwrite ? " (overwrite)\n" : " (create)\n");
                 evaluateCSVtoNormMetrics(samplesCsv.string(),
-                                         sampleMetrics.string());
+                                         sampleMetrics.string(), wanted);
+            }
+            continue;
+        }
+
+        if (entry.is_directory() && hasFile(entry.path(), "samples.idx")) {
+            const fs::path samplesIdx     = entry.path() / "samples.idx";
+            const fs::path arraysCsv      = findBaseArrays(entry.path());
+            const fs::path outDir         = fs::path(outputRoot) / fs::relative(entry.path(), inputRoot);
+            const fs::path sampleMetrics  = outDir / "sample_metrics.csv";
+            ensureDir(outDir.string());
+
+            if (!overwrite && fs::exists(sampleMetrics)) {
+                std::cout << "[SKIP] " << sampleMetrics.string()
+                          << " (exists; overwrite=false)\n";
+            } else {
+                std::cout << "[WRITE] " << sampleMetrics.string()
+                          << (overwrite ? " (overwrite)\n" : " (create)\n");
+                evaluateIndexSamplesToNormMetrics(samplesIdx.string(),
+                                                  arraysCsv.string(),
+                                                  sampleMetrics.string(), wanted);
             }
             continue;
         }
@@ -104,8 +141,478 @@ public:
 
     std::cout << "[OK] Full evaluation finished. Output at: " << outputRoot << "\n";
 }
+    // Writes sample_estimates.csv next to each sample_metrics.csv: the full-array estimate of
+    // every normalized metric with its bootstrap confidence interval, one row per sample.
+    // A non-empty `metrics` restricts the columns to those metrics.
+    void estimateAll(const std::string& inputRoot,
+                     const std::string& outputRoot,
+                     bool overwrite,
+                     const std::vector<Metric>& metrics = {}) const
+    {
+        const MetricMask wanted = metricMask(metrics);
+        if (!fs::exists(inputRoot)) {
+            throw std::runtime_error("Input root does not exist: " + inputRoot);
+        }
+        ensureDir(outputRoot);
+
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot)) {
+            if (!entry.is_directory()) continue;
+            const bool hasIdx = hasFile(entry.path(), "samples.idx");
+            if (!hasIdx && !hasFile(entry.path(), "samples.csv")) continue;
+
+            const fs::path outDir     = fs::path(outputRoot) / fs::relative(entry.path(), inputRoot);
+            const fs::path estimates  = outDir / "sample_estimates.csv";
+            ensureDir(outDir.string());
+
+            if (!overwrite && fs::exists(estimates)) {
+                std::cout << "[SKIP] " << estimates.string()
+                          << " (exists; overwrite=false)\n";
+                continue;
+            }
+            std::cout << "[WRITE] " << estimates.string()
+                      << (overwrite ? " (overwrite)\n" : " (create)\n");
+            estimateSamples(entry.path(), hasIdx, estimates.string(), wanted);
+        }
+
+        std::cout << "[OK] Estimation finished. Output at: " << outputRoot << "\n";
+    }
+
+    // Progressive estimates from every samples.pyr: one row per (array, level), coarse
+    // levels first, written to pyramid_estimates.csv. Levels are read incrementally, so a
+    // consumer can stop at the first level whose confidence interval is tight enough.
+    void evaluatePyramids(const std::string& inputRoot,
+                          const std::string& outputRoot,
+                          bool overwrite) const
+    {
+        if (!fs::exists(inputRoot)) {
+            throw std::runtime_error("Input root does not exist: " + inputRoot);
+        }
+        ensureDir(outputRoot);
+
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot)) {
+            if (!entry.is_directory() || !hasFile(entry.path(), "samples.pyr")) continue;
+
+            const fs::path outDir    = fs::path(outputRoot) / fs::relative(entry.path(), inputRoot);
+            const fs::path estimates = outDir / "pyramid_estimates.csv";
+            ensureDir(outDir.string());
+
+            if (!overwrite && fs::exists(estimates)) {
+                std::cout << "[SKIP] " << estimates.string()
+                          << " (exists; overwrite=false)\n";
+                continue;
+            }
+            std::cout << "[WRITE] " << estimates.string()
+                      << (overwrite ? " (overwrite)\n" : " (create)\n");
+            estimatePyramid(entry.path(), estimates.string());
+        }
+
+        std::cout << "[OK] Pyramid estimation finished. Output at: " << outputRoot << "\n";
+    }
+
+    // Adaptive sampling of every array in every arrays.csv: one row per array in
+    // adaptive_estimates.csv with the rounds, final sample size, whether the target standard
+    // error was reached, and the estimates of cfg.metrics.
+    void evaluateAdaptive(const std::string& inputRoot,
+                          const std::string& outputRoot,
+                          bool overwrite,
+                          const AdaptiveSampler::Config& cfg) const
+    {
+        if (!fs::exists(inputRoot)) {
+            throw std::runtime_error("Input root does not exist: " + inputRoot);
+        }
+        ensureDir(outputRoot);
+
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot)) {
+            if (!entry.is_regular_file() || entry.path().filename() != "arrays.csv") continue;
+
+            const fs::path outDir    = fs::path(outputRoot) / fs::relative(entry.path().parent_path(), inputRoot);
+            const fs::path estimates = outDir / "adaptive_estimates.csv";
+            ensureDir(outDir.string());
+
+            if (!overwrite && fs::exists(estimates)) {
+                std::cout << "[SKIP] " << estimates.string()
+                          << " (exists; overwrite=false)\n";
+                continue;
+            }
+            std::cout << "[WRITE] " << estimates.string()
+                      << (overwrite ? " (overwrite)\n" : " (create)\n");
+            estimateAdaptive(entry.path(), estimates.string(), cfg);
+        }
+
+        std::cout << "[OK] Adaptive estimation finished. Output at: " << outputRoot << "\n";
+    }
+
+    // Pairs every sample with its source array and writes one compact table with the bias,
+    // RMSE and Spearman rank correlation of each normalized metric, per set, sampling group
+    // and source ("sample" = raw sample metric, "estimate" = Estimator point estimate, only for
+    // the metrics the Estimator covers).
+    // Rows are streamed in batches of about 2^24 ints (arrays and samples); each batch is
+    // evaluated on `threads` workers. A non-empty `metrics` restricts the table, and the work,
+    // to those metrics.
+    void evaluateSamplingAccuracy(const std::string& inputRoot,
+                                  const std::string& outputCsv,
+                                  unsigned threads = std::thread::hardware_concurrency(),
+                                  const std::vector<Metric>& metrics = {}) const
+    {
+        if (!fs::exists(inputRoot)) {
+            throw std::runtime_error("Input root does not exist: " + inputRoot);
+        }
+        ensureDir(fs::path(outputCsv).parent_path().string());
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        }
+        ofs << "set,group,source,metric,count,bias,rmse,spearman\n";
+
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot)) {
+            if (!entry.is_regular_file() || entry.path().filename() != "arrays.csv") continue;
+            const fs::path setDir = entry.path().parent_path();
+            std::cout << "[COMPARE] " << setDir.string() << "\n";
+            compareSet(setDir, fs::relative(setDir, inputRoot).generic_string(), ofs, std::max(1u, threads), metrics);
+        }
+
+        std::cout << "[OK] Sampling accuracy written to: " << outputCsv << "\n";
+    }
+
+    // Which of the six metrics a `metrics` list selects, indexed by Metric; empty selects all.
+    using MetricMask = std::array<bool, 6>;
+    static MetricMask metricMask(const std::vector<Metric>& metrics) {
+        MetricMask wanted{};
+        wanted.fill(metrics.empty());
+        for (Metric m : metrics) wanted[static_cast<int>(m)] = true;
+        return wanted;
+    }
+
+    // The normalized metrics of one array, indexed by Metric. Only the wanted ones are
+    // computed; the others are NaN.
+    static std::array<double, 6> normMetrics(const std::vector<int>& a, const MetricMask& wanted = metricMask({})) {
+        DisorderMetrics dm;
+        const long long n = static_cast<long long>(a.size());
+        std::array<double, 6> m;
+        m.fill(std::numeric_limits<double>::quiet_NaN());
+        if (wanted[static_cast<int>(Metric::Inversions)]) m[static_cast<int>(Metric::Inversions)] = dm.normalizeInversions(dm.calculateInversions(a), n);
+        if (wanted[static_cast<int>(Metric::Runs)])       m[static_cast<int>(Metric::Runs)]       = dm.normalizeRuns(dm.calculateRuns(a), n);
+        if (wanted[static_cast<int>(Metric::Rem)])        m[static_cast<int>(Metric::Rem)]        = dm.normalizeRem(dm.calculateRem(a), n);
+        if (wanted[static_cast<int>(Metric::Osc)])        m[static_cast<int>(Metric::Osc)]        = dm.normalizeOsc(dm.calculateOsc(a), n);
+        if (wanted[static_cast<int>(Metric::Dis)])        m[static_cast<int>(Metric::Dis)]        = dm.normalizeDis(dm.calculateDis(a), n);
+        if (wanted[static_cast<int>(Metric::Ham)])        m[static_cast<int>(Metric::Ham)]        = dm.normalizeHam(dm.calculateHam(a), n);
+        return m;
+    }
+
+    // One arrays.csv / samples.csv row; false at end of file.
+    static bool readNextRow(std::istream& is, std::vector<int>& out) {
+        out.clear();
+        std::string line;
+        if (!std::getline(is, line)) return false;
+        std::stringstream ss(line);
+        std::string cell;
+        while (std::getline(ss, cell, ',')) {
+            out.push_back(cell.empty() ? 0 : std::stoi(cell));
+        }
+        return true;
+    }
+
+    // Strategy is encoded in the folder layout written by ExperimentConfigurator.
+    static SamplingStrategy strategyFromPath(const fs::path& samplesDir) {
+        const std::string p = samplesDir.generic_string();
+        if (p.find("value stratified sampling") != std::string::npos) return SamplingStrategy::VALUE_STRATIFIED;
+        if (p.find("cluster sampling")   != std::string::npos) return SamplingStrategy::CLUSTER;
+        if (p.find("combined sampling")  != std::string::npos) return SamplingStrategy::COMBINED;
+        if (p.find("reservoir sampling") != std::string::npos) return SamplingStrategy::RESERVOIR;
+        return SamplingStrategy::STRATIFIED;
+    }
+
 private:
 
+    struct SampleGroup {
+        std::string label;
+        SamplingStrategy strategy;
+        bool hasIdx;
+        std::ifstream in;
+    };
+
+
+    // Spearman correlation: Pearson on average ranks (ties share their mean rank).
+    static double spearman(const std::vector<double>& x, const std::vector<double>& y) {
+        auto ranks = [](const std::vector<double>& v) {
+            std::vector<size_t> order(v.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return v[a] < v[b]; });
+            std::vector<double> r(v.size());
+            for (size_t i = 0; i < order.size();) {
+                size_t j = i;
+                while (j + 1 < order.size() && v[order[j + 1]] == v[order[i]]) ++j;
+                const double avg = (static_cast<double>(i) + static_cast<double>(j)) / 2.0;
+                for (size_t k = i; k <= j; ++k) r[order[k]] = avg;
+                i = j + 1;
+            }
+            return r;
+        };
+        if (x.size() < 2) return 0.0;
+        const auto rx = ranks(x), ry = ranks(y);
+        const double mean = (static_cast<double>(x.size()) - 1.0) / 2.0;
+        double sxy = 0.0, sxx = 0.0, syy = 0.0;
+        for (size_t i = 0; i < rx.size(); ++i) {
+            sxy += (rx[i] - mean) * (ry[i] - mean);
+            sxx += (rx[i] - mean) * (rx[i] - mean);
+            syy += (ry[i] - mean) * (ry[i] - mean);
+        }
+        if (sxx == 0.0 || syy == 0.0) return 0.0;
+        return sxy / std::sqrt(sxx * syy);
+    }
+
+    static void compareSet(const fs::path& setDir, const std::string& setLabel,
+                           std::ofstream& ofs, unsigned threads,
+                           const std::vector<Metric>& metrics)
+    {
+        const fs::path arraysCsv = setDir / "arrays.csv";
+        std::vector<SampleGroup> groups;
+        for (const auto& entry : fs::recursive_directory_iterator(setDir)) {
+            if (!entry.is_directory()) continue;
+            const bool hasIdx = hasFile(entry.path(), "samples.idx");
+            if (!hasIdx && !hasFile(entry.path(), "samples.csv")) continue;
+            if (findBaseArrays(entry.path()) != arraysCsv) continue;
+
+            const fs::path file = entry.path() / (hasIdx ? "samples.idx" : "samples.csv");
+            groups.push_back({fs::relative(entry.path(), setDir).generic_string(),
+                              strategyFromPath(entry.path()), hasIdx,
+                              std::ifstream(file, hasIdx ? std::ios::binary : std::ios::in)});
+            if (!groups.back().in) throw std::runtime_error("Cannot open " + file.string());
+        }
+        std::sort(groups.begin(), groups.end(),
+                  [](const SampleGroup& a, const SampleGroup& b) { return a.label < b.label; });
+        if (groups.empty()) return;
+
+        std::ifstream base(arraysCsv);
+        if (!base) throw std::runtime_error("Cannot open " + arraysCsv.string());
+
+        const size_t G = groups.size();
+        const MetricMask wanted = metricMask(metrics);
+        // ints resident per batch (arrays plus their samples); at least one row per batch
+        constexpr size_t BATCH_ELEMENTS = size_t{1} << 24;
+        constexpr int SOURCES = 2; // 0 = sample, 1 = estimate
+
+        // truth[metric][row], got[group][source][metric][row]
+        std::array<std::vector<double>, 6> truth;
+        std::vector<std::array<std::array<std::vector<double>, 6>, SOURCES>> got(G);
+
+        std::vector<std::vector<int>> arrays;
+        std::vector<std::vector<std::vector<int>>> samples, positions;
+        bool more = true;
+        while (more) {
+            // 1) read one batch: an array row and its row in every group
+            arrays.clear();
+            samples.clear();
+            positions.clear();
+            std::vector<int> row;
+            size_t resident = 0;
+            while (arrays.empty() || resident < BATCH_ELEMENTS) {
+                if (!readNextRow(base, row)) { more = false; break; }
+                if (row.empty()) continue;
+                samples.emplace_back(G);
+                positions.emplace_back(G);
+                for (size_t g = 0; g < G; ++g) {
+                    bool ok;
+                    if (groups[g].hasIdx) {
+                        ok = SampleCodec::readRow(groups[g].in, positions.back()[g]);
+                        if (ok) samples.back()[g] = SampleCodec::gather(row, positions.back()[g]);
+                    } else {
+                        ok = readNextRow(groups[g].in, samples.back()[g]);
+                    }
+                    if (!ok) throw std::runtime_error("Fewer samples than arrays in: " + groups[g].label);
+                    resident += samples.back()[g].size() + positions.back()[g].size();
+                }
+                resident += row.size();
+                arrays.push_back(std::move(row));
+                row.clear();
+            }
+
+            // 2) evaluate the batch in parallel
+            const size_t rows = arrays.size();
+            std::vector<std::array<double, 6>> truthBatch(rows);
+            std::vector<std::vector<std::array<std::array<double, 6>, SOURCES>>> gotBatch(
+                rows, std::vector<std::array<std::array<double, 6>, SOURCES>>(G));
+
+            auto worker = [&](unsigned t) {
+                std::vector<Estimator> est;
+                est.reserve(G);
+                for (size_t g = 0; g < G; ++g) est.emplace_back(groups[g].strategy, 0, 0.95, 0u);
+                for (size_t r = t; r < rows; r += threads) {
+                    truthBatch[r] = normMetrics(arrays[r], wanted);
+                    for (size_t g = 0; g < G; ++g) {
+                        const auto& smp = samples[r][g];
+                        gotBatch[r][g][0] = normMetrics(smp, wanted);
+                        gotBatch[r][g][1] = est[g].pointEstimate(
+                            smp, Estimator::splitUnits(positions[r][g], static_cast<int>(smp.size())));
+                    }
+                }
+            };
+            std::vector<std::thread> pool;
+            for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+            worker(0);
+            for (auto& th : pool) th.join();
+
+            // 3) append in row order
+            for (size_t r = 0; r < rows; ++r) {
+                for (int m = 0; m < 6; ++m) truth[m].push_back(truthBatch[r][m]);
+                for (size_t g = 0; g < G; ++g)
+                    for (int src = 0; src < SOURCES; ++src)
+                        for (int m = 0; m < 6; ++m) got[g][src][m].push_back(gotBatch[r][g][src][m]);
+            }
+        }
+
+        static const char* metricNames[6] = {"inv", "runs", "rem", "osc", "dis", "ham"};
+        static const char* sourceNames[SOURCES] = {"sample", "estimate"};
+        for (size_t g = 0; g < G; ++g) {
+            for (int src = 0; src < SOURCES; ++src) {
+                for (int m = 0; m < 6; ++m) {
+                    if (!wanted[m]) continue;
+                    if (src == 1 && !Estimator::estimable(static_cast<Metric>(m), groups[g].strategy)) continue;
+                    // rows the Estimator could not estimate (no adjacent pairs) are left out
+                    std::vector<double> x, y;
+                    for (size_t i = 0; i < truth[m].size(); ++i) {
+                        if (std::isnan(got[g][src][m][i])) continue;
+                        x.push_back(got[g][src][m][i]);
+                        y.push_back(truth[m][i]);
+                    }
+                    double bias = 0.0, sq = 0.0;
+                    for (size_t i = 0; i < x.size(); ++i) {
+                        bias += x[i] - y[i];
+                        sq   += (x[i] - y[i]) * (x[i] - y[i]);
+                    }
+                    const double cnt = std::max<double>(1.0, static_cast<double>(x.size()));
+                    ofs << setLabel << ',' << groups[g].label << ',' << sourceNames[src] << ','
+                        << metricNames[m] << ',' << x.size() << ',' << bias / cnt << ','
+                        << std::sqrt(sq / cnt) << ',' << spearman(x, y) << '\n';
+                }
+            }
+        }
+    }
+
+    static void estimatePyramid(const fs::path& pyramidDir, const std::string& outputCsv) {
+        const std::string pyrPath   = (pyramidDir / "samples.pyr").string();
+        const std::string arraysCsv = findBaseArrays(pyramidDir).string();
+        std::ifstream pyr(pyrPath, std::ios::binary);
+        std::ifstream base(arraysCsv);
+        if (!pyr || !base) throw std::runtime_error("Cannot open " + pyrPath + " or " + arraysCsv);
+
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        }
+        ofs << "array,level,n";
+        writeEstimateHeader(ofs, metricMask({}));
+
+        Estimator est(SamplingStrategy::STRATIFIED);
+        std::vector<std::vector<int>> increments;
+        std::vector<int> row;
+        std::vector<int> positions;
+        for (long long a = 0; SamplePyramid::read(pyr, increments); ++a) {
+            if (!readNextRow(base, row)) {
+                throw std::runtime_error("More pyramids than arrays in: " + arraysCsv);
+            }
+            positions.clear();
+            for (size_t level = 0; level < increments.size(); ++level) {
+                const size_t mid = positions.size();
+                positions.insert(positions.end(), increments[level].begin(), increments[level].end());
+                std::inplace_merge(positions.begin(), positions.begin() + mid, positions.end());
+
+                const auto e = est.estimate(SampleCodec::gather(row, positions), positions);
+                ofs << a << ',' << level << ',' << positions.size();
+                writeEstimateCells(ofs, e, metricMask({}));
+            }
+        }
+    }
+
+    // <m>_est,<m>_se,<m>_lo,<m>_hi for each wanted metric the Estimator covers (Estimator::estimable).
+    static void writeEstimateHeader(std::ofstream& ofs, const MetricMask& wanted) {
+        static const char* metricNames[6] = {"inv", "runs", "rem", "osc", "dis", "ham"};
+        for (int m = 0; m < 6; ++m) {
+            if (!wanted[m] || !Estimator::estimable(static_cast<Metric>(m))) continue;
+            const std::string name = metricNames[m];
+            ofs << ',' << name << "_est," << name << "_se," << name << "_lo," << name << "_hi";
+        }
+        ofs << '\n';
+    }
+
+    static void writeEstimateCells(std::ofstream& ofs, const Estimator::DisorderEstimate& e,
+                                   const MetricMask& wanted) {
+        for (int m = 0; m < 6; ++m) {
+            if (!wanted[m] || !Estimator::estimable(static_cast<Metric>(m))) continue;
+            const Estimator::Estimate& x = e.byMetric[m];
+            ofs << ',' << x.value << ',' << x.stdError << ',' << x.lo << ',' << x.hi;
+        }
+        ofs << '\n';
+    }
+
+    static void estimateAdaptive(const fs::path& arraysCsv, const std::string& outputCsv,
+                                 const AdaptiveSampler::Config& cfg) {
+        std::ifstream ifs(arraysCsv);
+        if (!ifs) throw std::runtime_error("Cannot open input csv: " + arraysCsv.string());
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        }
+        const MetricMask wanted = metricMask(cfg.metrics);
+        ofs << "array,rounds,n,converged";
+        writeEstimateHeader(ofs, wanted);
+
+        std::vector<int> row;
+        for (long long a = 0; readNextRow(ifs, row); ++a) {
+            if (row.empty()) continue;
+            const auto res = AdaptiveSampler(row, cfg).run();
+            ofs << a << ',' << res.rounds << ',' << res.indices.size() << ',' << res.converged;
+            writeEstimateCells(ofs, res.estimate, wanted);
+        }
+    }
+
+    // Positions are only known for samples.idx (index mode). From samples.csv every element is
+    // its own unit, so cluster samples get neither the cross-unit inversion correction nor a
+    // cluster bootstrap.
+    static void estimateSamples(const fs::path& samplesDir, bool hasIdx, const std::string& outputCsv,
+                                const MetricMask& wanted) {
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        }
+        ofs << "n";
+        writeEstimateHeader(ofs, wanted);
+
+        Estimator est(strategyFromPath(samplesDir));
+        auto writeRow = [&](const std::vector<int>& sample, const std::vector<int>& indices) {
+            const auto e = est.estimate(sample, indices);
+            ofs << sample.size();
+            writeEstimateCells(ofs, e, wanted);
+        };
+
+        std::vector<int> row;
+        if (hasIdx) {
+            const std::string idxPath = (samplesDir / "samples.idx").string();
+            const std::string arraysCsv = findBaseArrays(samplesDir).string();
+            std::ifstream idx(idxPath, std::ios::binary);
+            std::ifstream base(arraysCsv);
+            if (!idx || !base) throw std::runtime_error("Cannot open " + idxPath + " or " + arraysCsv);
+
+            std::vector<int> indices;
+            while (SampleCodec::readRow(idx, indices)) {
+                if (!readNextRow(base, row)) {
+                    throw std::runtime_error("More samples than arrays in: " + arraysCsv);
+                }
+                if (indices.empty()) continue;
+                writeRow(SampleCodec::gather(row, indices), indices);
+            }
+            return;
+        }
+
+        const std::string csvPath = (samplesDir / "samples.csv").string();
+        std::ifstream ifs(csvPath);
+        if (!ifs) throw std::runtime_error("Cannot open input csv: " + csvPath);
+        while (readNextRow(ifs, row)) {
+            if (row.empty()) continue;
+            writeRow(row, {});
+        }
+    }
+
     static void ensureDir(const std::string& path) {
         std::error_code ec;
         fs::create_directories(path, ec);
@@ -128,31 +635,19 @@ private:
     }
 
 
-    static bool readNextRow(std::istream& is, std::vector<int>& out) {
-        out.clear();
-        std::string line;
-        if (!std::getline(is, line)) return false;
-        std::stringstream ss(line);
-        std::string cell;
-        while (std::getline(ss, cell, ',')) {
-            out.push_back(cell.empty() ? 0 : std::stoi(cell));
-        }
-        return true;
-    }
 
-    static void writeHeaderNorm(std::ofstream& ofs) {
-        ofs << "n,"
-            << "inv_norm,"
-            << "runs_norm,"
-            << "rem_norm,"
-            << "osc_norm,"
-            << "dis_norm,"
-            << "ham_norm"
-            << "\n";
+    static void writeHeaderNorm(std::ofstream& ofs, const MetricMask& wanted) {
+        static const char* metricNames[6] = {"inv", "runs", "rem", "osc", "dis", "ham"};
+        ofs << "n";
+        for (int m = 0; m < 6; ++m) {
+            if (wanted[m]) ofs << ',' << metricNames[m] << "_norm";
+        }
+        ofs << "\n";
     }
 
     static void evaluateCSVtoNormMetrics(const std::string& inputCsv,
-                                         const std::string& outputCsv)
+                                         const std::string& outputCsv,
+                                         const MetricMask& wanted)
     {
         std::ifstream ifs(inputCsv);
         if (!ifs) {
@@ -164,43 +659,66 @@ private:
             throw std::runtime_error("Cannot open output csv: " + outputCsv);
         }
 
-        writeHeaderNorm(ofs);
+        writeHeaderNorm(ofs, wanted);
 
         std::vector<int> row;
         while (readNextRow(ifs, row)) {
             if (row.empty()) continue;
-            writeNormMetricsLine(ofs, row);
+            writeNormMetricsLine(ofs, row, wanted);
         }
     }
 
 
-    static void writeNormMetricsLine(std::ofstream& ofs, const std::vector<int>& a) {
-        DisorderMetrics dm;
+    // samples.idx lives under <set>/samples/...; its base arrays.csv is in the nearest ancestor.
+    static fs::path findBaseArrays(const fs::path& samplesDir) {
+        for (fs::path p = samplesDir; p.has_relative_path(); p = p.parent_path()) {
+            if (fs::exists(p / "arrays.csv")) return p / "arrays.csv";
+        }
+        throw std::runtime_error("No arrays.csv above: " + samplesDir.string());
+    }
 
-        const long long n = static_cast<long long>(a.size());
+    // Row i of samples.idx indexes into row i of arrays.csv; both are streamed together,
+    // so only one base array is resident at a time.
+    static void evaluateIndexSamplesToNormMetrics(const std::string& inputIdx,
+                                                  const std::string& arraysCsv,
+                                                  const std::string& outputCsv,
+                                                  const MetricMask& wanted)
+    {
+        std::ifstream idx(inputIdx, std::ios::binary);
+        if (!idx) {
+            throw std::runtime_error("Cannot open input idx: " + inputIdx);
+        }
+        std::ifstream base(arraysCsv);
+        if (!base) {
+            throw std::runtime_error("Cannot open base csv: " + arraysCsv);
+        }
 
-        const long long runs = dm.calculateRuns(a);
-        const long long inv  = dm.calculateInversions(a);
-        const long long rem  = dm.calculateRem(a);
-        const long long osc  = dm.calculateOsc(a);
-        const long long dis  = dm.calculateDis(a);
-        const long long ham  = dm.calculateHam(a);
-
-        const double runsNorm = dm.normalizeRuns(runs, n);
-        const double invNorm  = dm.normalizeInversions(inv, n);
-        const double remNorm  = dm.normalizeRem(rem, n);
-        const double oscNorm  = dm.normalizeOsc(osc, n);
-        const double disNorm  = dm.normalizeDis(dis, n);
-        const double hamNorm  = dm.normalizeHam(ham, n);
-
-        ofs << n
-            << ',' << invNorm
-            << ',' << runsNorm
-            << ',' << remNorm
-            << ',' << oscNorm
-            << ',' << disNorm
-            << ',' << hamNorm
-            << '\n';
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        }
+
+        writeHeaderNorm(ofs, wanted);
+
+        std::vector<int> indices;
+        std::vector<int> row;
+        while (SampleCodec::readRow(idx, indices)) {
+            if (!readNextRow(base, row)) {
+                throw std::runtime_error("More samples than arrays in: " + arraysCsv);
+            }
+            if (indices.empty()) continue;
+            writeNormMetricsLine(ofs, SampleCodec::gather(row, indices), wanted);
+        }
+    }
+
+    // Only the wanted metrics are computed.
+    static void writeNormMetricsLine(std::ofstream& ofs, const std::vector<int>& a, const MetricMask& wanted) {
+        const auto metrics = normMetrics(a, wanted);
+        ofs << a.size();
+        for (int m = 0; m < 6; ++m) {
+            if (wanted[m]) ofs << ',' << metrics[m];
+        }
+        ofs << '\n';
     }
 };
 #endif //CHARTBUILDER_H
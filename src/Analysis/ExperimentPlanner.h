@@ -0,0 +1,223 @@
+
+
+#ifndef EXPERIMENTPLANNER_H
+#define EXPERIMENTPLANNER_H
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Evaluator.h"
+#include "ExperimentSpec.h"
+#include "../Data/ExperimentConfigurator.h"
+
+
+// Expands an ExperimentSpec into a task graph and runs it on spec.threads workers:
+//
+//   shard:<set>#i  (generate + sample, one pass per shard)  ->  merge:<set>
+//   merge:<set>  ->  metrics / estimates / pyramids / adaptive:<set>
+//   every merge  ->  accuracy (one table over the whole root)
+//
+// Tasks are keyed by name, so work shared by several spec entries (a size listed twice, run
+// counts with the same label) is planned once. Sets already complete under the root only get
+// their evaluation tasks. Parallelism is across tasks: each shard generates on one thread.
+class ExperimentPlanner {
+public:
+    struct Task {
+        std::string name;
+        std::function<void()> run;
+        std::vector<size_t> deps;
+    };
+
+    explicit ExperimentPlanner(ExperimentSpec spec) : spec_(std::move(spec)) {
+        for (int n : spec_.sizes) configurators_.emplace_back(configFor(n));
+        plan();
+    }
+
+    // tasks capture `this` and the configurators
+    ExperimentPlanner(const ExperimentPlanner&) = delete;
+    ExperimentPlanner& operator=(const ExperimentPlanner&) = delete;
+
+    const std::vector<Task>& tasks() const { return tasks_; }
+
+    // Runs every task once its dependencies are done. The first failure stops new tasks from
+    // starting and is rethrown after the running ones finish.
+    void run() const {
+        const size_t total = tasks_.size();
+        std::vector<size_t> pending(total);
+        std::vector<std::vector<size_t>> dependents(total);
+        std::deque<size_t> ready;
+        for (size_t t = 0; t < total; ++t) {
+            pending[t] = tasks_[t].deps.size();
+            for (size_t d : tasks_[t].deps) dependents[d].push_back(t);
+            if (pending[t] == 0) ready.push_back(t);
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t finished = 0;
+        std::exception_ptr error;
+
+        auto worker = [&] {
+            std::unique_lock lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return !ready.empty() || finished == total || error; });
+                if (error || ready.empty()) return;
+                const size_t t = ready.front();
+                ready.pop_front();
+
+                lock.unlock();
+                std::exception_ptr failure;
+                try {
+                    tasks_[t].run();
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+                lock.lock();
+
+                ++finished;
+                if (failure && !error) error = failure;
+                for (size_t d : dependents[t]) {
+                    if (--pending[d] == 0) ready.push_back(d);
+                }
+                cv.notify_all();
+            }
+        };
+
+        const unsigned threads = std::max(1u, spec_.threads);
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+        if (error) std::rethrow_exception(error);
+
+        std::cout << "[OK] " << total << " tasks finished (seed "
+                  << configurators_.front().getSeed() << ")\n";
+    }
+
+private:
+    ExperimentSpec spec_;
+    std::vector<ExperimentConfigurator> configurators_; // one per entry of spec_.sizes
+    std::vector<Task> tasks_;
+    std::map<std::string, size_t> byName_;
+    std::set<std::string> plannedSets_;
+
+    ExperimentConfigurator::Config configFor(int n) const {
+        ExperimentConfigurator::Config cfg{n, spec_.sampleSize, spec_.minValue,
+                                           ExperimentSpec::resolve(spec_.maxValue, n), spec_.root};
+        cfg.masterSeed = spec_.seed;
+        cfg.threads = 1;
+        cfg.batchSize = spec_.batchSize;
+        cfg.shardSize = spec_.shardSize;
+        cfg.indexOnlySamples = spec_.indexOnlySamples;
+        cfg.writePyramid = spec_.writePyramid;
+        cfg.valueStratified = spec_.valueStratified;
+        if (!spec_.clusterGroups.empty()) cfg.clusterGroups = spec_.clusterGroups;
+        if (!spec_.stratumGroups.empty()) cfg.stratumGroups = spec_.stratumGroups;
+        return cfg;
+    }
+
+    // spec.metrics narrowed to what the adaptive strategy estimates; empty: all of those.
+    AdaptiveSampler::Config adaptiveFor(int n) const {
+        AdaptiveSampler::Config cfg;
+        cfg.strategy = spec_.adaptiveStrategy;
+        cfg.targetStdError = spec_.adaptiveTarget;
+        cfg.budget = ExperimentSpec::resolve(spec_.adaptiveBudget, n);
+        cfg.metrics.clear();
+        for (int m = 0; m < 6; ++m) {
+            const Metric metric = static_cast<Metric>(m);
+            const bool listed = spec_.metrics.empty() ||
+                std::find(spec_.metrics.begin(), spec_.metrics.end(), metric) != spec_.metrics.end();
+            if (listed && Estimator::estimable(metric, cfg.strategy)) cfg.metrics.push_back(metric);
+        }
+        return cfg;
+    }
+
+    // Returns the id of the task called `name`, adding it first if it is new.
+    size_t add(const std::string& name, std::function<void()> run, std::vector<size_t> deps = {}) {
+        const auto it = byName_.find(name);
+        if (it != byName_.end()) return it->second;
+        tasks_.push_back({name, std::move(run), std::move(deps)});
+        byName_.emplace(name, tasks_.size() - 1);
+        return tasks_.size() - 1;
+    }
+
+    void plan() {
+        std::vector<size_t> merges;
+        for (size_t c = 0; c < configurators_.size(); ++c) {
+            const int n = spec_.sizes[c];
+            for (ArrayType type : spec_.types) {
+                const std::vector<std::string>* params = nullptr;
+                if (type == ArrayType::RANDOM_ARRAY) params = &spec_.kValues;
+                else if (type == ArrayType::RUNS_ARRAY) params = &spec_.runsValues;
+                else if (ExperimentSpec::isWorkload(type)) params = &spec_.workloadParams;
+
+                if (!params) {
+                    planSet(configurators_[c], n, type, 0, merges);
+                    continue;
+                }
+                for (const auto& expr : *params) {
+                    planSet(configurators_[c], n, type, ExperimentSpec::resolve(expr, n), merges);
+                }
+            }
+        }
+
+        if (spec_.evaluateAccuracy) {
+            add("accuracy", [this] {
+                const std::string csv = (std::filesystem::path(spec_.output) / "sampling_accuracy.csv").string();
+                Evaluator{}.evaluateSamplingAccuracy(spec_.root, csv, spec_.threads, spec_.metrics);
+            }, merges);
+        }
+    }
+
+    void planSet(const ExperimentConfigurator& conf, int n, ArrayType type, int param, std::vector<size_t>& merges) {
+        const std::string key = conf.setKey(type, param);
+        if (!plannedSets_.insert(key).second) return;
+
+        const int count = spec_.count;
+        const int runs = type == ArrayType::RUNS_ARRAY ? param : 0;
+        const int k = type == ArrayType::RUNS_ARRAY ? 0 : param;
+
+        std::vector<size_t> ready;
+        if (!conf.isComplete(key)) {
+            std::vector<size_t> shards;
+            for (int s = 0; s < conf.shardCount(count); ++s) {
+                shards.push_back(add("shard:" + key + "#" + std::to_string(s), [&conf, key, count, s, type, runs, k] {
+                    conf.buildShard(key, count, s, type, runs, k);
+                }));
+            }
+            const size_t merge = add("merge:" + key, [&conf, key, count] { conf.mergeSet(key, count); }, shards);
+            merges.push_back(merge);
+            ready.push_back(merge);
+        }
+
+        const std::string in = (std::filesystem::path(spec_.root) / key).string();
+        const std::string out = (std::filesystem::path(spec_.output) / key).string();
+        // spec.metrics narrows these tables as well as the accuracy table
+        const std::vector<Metric> metrics = spec_.metrics;
+        if (spec_.evaluateMetrics) {
+            add("metrics:" + key, [in, out, metrics] { Evaluator{}.evaluateAll(in, out, true, true, metrics); }, ready);
+        }
+        if (spec_.evaluateEstimates) {
+            add("estimates:" + key, [in, out, metrics] { Evaluator{}.estimateAll(in, out, true, metrics); }, ready);
+        }
+        if (spec_.evaluatePyramids && spec_.writePyramid) {
+            add("pyramids:" + key, [in, out] { Evaluator{}.evaluatePyramids(in, out, true); }, ready);
+        }
+        if (spec_.evaluateAdaptive) {
+            const AdaptiveSampler::Config cfg = adaptiveFor(n);
+            add("adaptive:" + key, [in, out, cfg] { Evaluator{}.evaluateAdaptive(in, out, true, cfg); }, ready);
+        }
+    }
+};
+
+#endif //EXPERIMENTPLANNER_H
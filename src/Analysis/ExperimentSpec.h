@@ -0,0 +1,265 @@
+
+
+#ifndef EXPERIMENTSPEC_H
+#define EXPERIMENTSPEC_H
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Metric.h"
+#include "../Data/ArrayType.h"
+#include "../Data/SamplingStrategy.h"
+
+
+// One experiment sweep, read from a text file of `key = value` lines ('#' starts a comment,
+// lists are comma separated):
+//
+//   root = data/input             output = data/output
+//   seed = 42                     threads = 8
+//   sizes = 10000, 100000         count = 1000         sample_size = 100
+//   min_value = 0                 max_value = n
+//   types = permutation, random, runs, nearly_sorted
+//   k = 2500, n div 2             runs = 13, sqrt n, log2 n      workload_params = 100
+//   cluster_groups = sqrt, log2   stratum_groups = smlLength, n div 10   value_stratified = yes
+//   metrics = inv, rem            evaluate = metrics, estimates, accuracy, adaptive
+//   adaptive_strategy = cluster   adaptive_target = 0.01   adaptive_budget = n div 10
+//
+// Size-dependent values (max_value, k, runs, workload_params, adaptive_budget) are expressions
+// in n, resolved per size: an integer, "n", "sqrt n", "2sqrt n", "log2 n" or "n div D".
+struct ExperimentSpec {
+    std::string root;
+    std::string output;
+    std::optional<std::uint64_t> seed;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<int> sizes;
+    int count = 100;
+    int sampleSize = 100;
+    int minValue = 0;
+    std::string maxValue = "n";
+
+    std::vector<ArrayType> types;
+    std::vector<std::string> kValues;
+    std::vector<std::string> runsValues;
+    std::vector<std::string> workloadParams;
+
+    // empty: ExperimentConfigurator::Config defaults
+    std::vector<std::string> clusterGroups;
+    std::vector<std::string> stratumGroups;
+    // Metrics in the metrics, estimates and accuracy outputs; empty: all six.
+    std::vector<Metric> metrics;
+
+    bool evaluateMetrics = false;
+    bool evaluateEstimates = false;
+    bool evaluatePyramids = false;
+    bool evaluateAccuracy = false;
+    bool evaluateAdaptive = false;
+
+    // AdaptiveSampler runs of the adaptive step, one per array
+    SamplingStrategy adaptiveStrategy = SamplingStrategy::STRATIFIED;
+    double adaptiveTarget = 0.01;
+    std::string adaptiveBudget = "n div 10";
+
+    bool indexOnlySamples = false;
+    bool writePyramid = false;
+    bool valueStratified = false;
+    int shardSize = 100;
+    int batchSize = 64;
+
+    static ExperimentSpec load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open spec: " + path);
+        return parse(in);
+    }
+
+    static ExperimentSpec parse(std::istream& in) {
+        ExperimentSpec spec;
+        std::string line;
+        int lineNo = 0;
+        while (std::getline(in, line)) {
+            ++lineNo;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+            const size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                throw std::runtime_error("Spec line " + std::to_string(lineNo) + ": expected key = value");
+            }
+            const std::string key = trim(line.substr(0, eq));
+            const std::string value = trim(line.substr(eq + 1));
+            try {
+                spec.set(key, value);
+            } catch (const std::exception& e) {
+                throw std::runtime_error("Spec line " + std::to_string(lineNo) + " (" + key + "): " + e.what());
+            }
+        }
+
+        if (spec.root.empty()) throw std::runtime_error("Spec has no root");
+        if (spec.sizes.empty()) throw std::runtime_error("Spec has no sizes");
+        if (spec.types.empty()) throw std::runtime_error("Spec has no types");
+        auto needs = [&](ArrayType t) { return std::find(spec.types.begin(), spec.types.end(), t) != spec.types.end(); };
+        if (needs(ArrayType::RANDOM_ARRAY) && spec.kValues.empty()) throw std::runtime_error("Spec lists random but no k");
+        if (needs(ArrayType::RUNS_ARRAY) && spec.runsValues.empty()) throw std::runtime_error("Spec lists runs but no runs");
+        const bool anyWorkload = std::any_of(spec.types.begin(), spec.types.end(), isWorkload);
+        if (anyWorkload && spec.workloadParams.empty()) throw std::runtime_error("Spec lists a workload but no workload_params");
+        if (spec.evaluating() && spec.output.empty()) throw std::runtime_error("Spec evaluates but has no output");
+        try {
+            for (int n : spec.sizes) {
+                resolve(spec.maxValue, n); // reject bad expressions before anything runs
+                for (const auto& v : spec.kValues) resolve(v, n);
+                for (const auto& v : spec.runsValues) resolve(v, n);
+                for (const auto& v : spec.workloadParams) resolve(v, n);
+                resolve(spec.adaptiveBudget, n);
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error(std::string("Spec expression: ") + e.what());
+        }
+        return spec;
+    }
+
+    bool evaluating() const {
+        return evaluateMetrics || evaluateEstimates || evaluatePyramids || evaluateAccuracy || evaluateAdaptive;
+    }
+
+    static int resolve(const std::string& expr, int n) {
+        const std::string e = lower(expr);
+        if (e == "n")       return n;
+        if (e == "sqrt n")  return std::max(1, (int)std::floor(std::sqrt((double)n)));
+        if (e == "2sqrt n") return 2 * std::max(1, (int)std::floor(std::sqrt((double)n)));
+        if (e == "log2 n")  return std::max(1, (int)std::floor(std::log2((double)n)));
+        if (e.rfind("n div ", 0) == 0) {
+            const int d = toInt(e.substr(6));
+            if (d <= 0) throw std::invalid_argument("Divisor must be positive: " + expr);
+            return n / d;
+        }
+        return toInt(e);
+    }
+
+    static bool isWorkload(ArrayType t) {
+        return t >= ArrayType::NEARLY_SORTED_ARRAY;
+    }
+
+    static ArrayType typeFromName(const std::string& name) {
+        const std::string s = lower(name);
+        if (s == "permutation")   return ArrayType::PERMUTATION_ARRAY;
+        if (s == "random")        return ArrayType::RANDOM_ARRAY;
+        if (s == "sorted")        return ArrayType::SORTED_ARRAY;
+        if (s == "reverse")       return ArrayType::REVERSE_ARRAY;
+        if (s == "runs")          return ArrayType::RUNS_ARRAY;
+        if (s == "nearly_sorted") return ArrayType::NEARLY_SORTED_ARRAY;
+        if (s == "sorted_tail")   return ArrayType::SORTED_TAIL_ARRAY;
+        if (s == "sawtooth")      return ArrayType::SAWTOOTH_ARRAY;
+        if (s == "organ_pipe")    return ArrayType::ORGAN_PIPE_ARRAY;
+        if (s == "zipf")          return ArrayType::ZIPF_ARRAY;
+        if (s == "interleaved")   return ArrayType::INTERLEAVED_ARRAY;
+        throw std::invalid_argument("Unknown array type: " + name);
+    }
+
+    // Same names as the metric column of the sampling accuracy table.
+    static Metric metricFromName(const std::string& name) {
+        const std::string s = lower(name);
+        if (s == "inv")  return Metric::Inversions;
+        if (s == "runs") return Metric::Runs;
+        if (s == "rem")  return Metric::Rem;
+        if (s == "osc")  return Metric::Osc;
+        if (s == "dis")  return Metric::Dis;
+        if (s == "ham")  return Metric::Ham;
+        throw std::invalid_argument("Unknown metric: " + name);
+    }
+
+private:
+    void set(const std::string& key, const std::string& value) {
+        if (key == "root")                 root = value;
+        else if (key == "output")          output = value;
+        else if (key == "seed")            seed = std::stoull(value);
+        else if (key == "threads")         threads = static_cast<unsigned>(std::max(1, toInt(value)));
+        else if (key == "sizes")           { sizes.clear(); for (const auto& v : split(value)) sizes.push_back(toInt(v)); }
+        else if (key == "count")           count = toInt(value);
+        else if (key == "sample_size")     sampleSize = toInt(value);
+        else if (key == "min_value")       minValue = toInt(value);
+        else if (key == "max_value")       maxValue = value;
+        else if (key == "types")           { types.clear(); for (const auto& v : split(value)) types.push_back(typeFromName(v)); }
+        else if (key == "k")               kValues = split(value);
+        else if (key == "runs")            runsValues = split(value);
+        else if (key == "workload_params") workloadParams = split(value);
+        else if (key == "cluster_groups")  clusterGroups = split(value);
+        else if (key == "stratum_groups")  stratumGroups = split(value);
+        else if (key == "metrics")         { metrics.clear(); for (const auto& v : split(value)) metrics.push_back(metricFromName(v)); }
+        else if (key == "evaluate")        setEvaluate(split(value));
+        else if (key == "index_only")      indexOnlySamples = toBool(value);
+        else if (key == "pyramid")         writePyramid = toBool(value);
+        else if (key == "value_stratified") valueStratified = toBool(value);
+        else if (key == "shard_size")      shardSize = toInt(value);
+        else if (key == "batch_size")      batchSize = toInt(value);
+        else if (key == "adaptive_strategy") adaptiveStrategy = adaptiveStrategyFromName(value);
+        else if (key == "adaptive_target") adaptiveTarget = std::stod(value);
+        else if (key == "adaptive_budget") adaptiveBudget = value;
+        else throw std::invalid_argument("Unknown key");
+    }
+
+    void setEvaluate(const std::vector<std::string>& steps) {
+        evaluateMetrics = evaluateEstimates = evaluatePyramids = evaluateAccuracy = evaluateAdaptive = false;
+        for (const auto& step : steps) {
+            const std::string s = lower(step);
+            if (s == "metrics")        evaluateMetrics = true;
+            else if (s == "estimates") evaluateEstimates = true;
+            else if (s == "pyramids")  evaluatePyramids = true;
+            else if (s == "accuracy")  evaluateAccuracy = true;
+            else if (s == "adaptive")  evaluateAdaptive = true;
+            else if (s != "none")      throw std::invalid_argument("Unknown evaluate step: " + step);
+        }
+    }
+
+    static SamplingStrategy adaptiveStrategyFromName(const std::string& name) {
+        const std::string s = lower(name);
+        if (s == "stratified") return SamplingStrategy::STRATIFIED;
+        if (s == "cluster")    return SamplingStrategy::CLUSTER;
+        throw std::invalid_argument("Adaptive sampling is stratified or cluster: " + name);
+    }
+
+    static std::string trim(const std::string& s) {
+        const size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+    }
+
+    static std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return s;
+    }
+
+    static std::vector<std::string> split(const std::string& value) {
+        std::vector<std::string> out;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = trim(item);
+            if (!item.empty()) out.push_back(item);
+        }
+        return out;
+    }
+
+    static int toInt(const std::string& s) {
+        size_t used = 0;
+        const int v = std::stoi(s, &used);
+        if (used != s.size()) throw std::invalid_argument("Not an integer: " + s);
+        return v;
+    }
+
+    static bool toBool(const std::string& s) {
+        const std::string v = lower(s);
+        if (v == "true" || v == "yes" || v == "1")  return true;
+        if (v == "false" || v == "no" || v == "0") return false;
+        throw std::invalid_argument("Not a boolean: " + s);
+    }
+};
+
+#endif //EXPERIMENTSPEC_H
@@ -0,0 +1,252 @@
+
+
+#ifndef SORTBENCHMARK_H
+#define SORTBENCHMARK_H
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Evaluator.h"
+#include "../Algotrithms/AdaptiveShiversSort.h"
+#include "../Algotrithms/BinaryInsertionSort.h"
+#include "../Algotrithms/InsertionSort.h"
+#include "../Algotrithms/MergeSort.h"
+#include "../Algotrithms/PowerSort.h"
+#include "../Algotrithms/QuickSort.h"
+#include "../Algotrithms/TimSort.h"
+
+
+// Times every registered sort on every array of the ExperimentConfigurator sets under a root
+// and writes one row per (array, algorithm): time percentiles over the repetitions, cycles
+// per element, whether the output equals the sorted input, and the array's normalized
+// disorder metrics, so runtime can be related to presortedness. Instrumented algorithms are
+// timed in their NullCounter form and counted in one extra, untimed CountingCounter run.
+//
+// Each repetition sorts a fresh copy of the array; only the sort itself is timed. Sets and
+// arrays are visited in path / file order, so a rerun measures the same inputs in the same order.
+class SortBenchmark {
+public:
+    struct Algorithm {
+        std::string name;
+        std::function<void(std::vector<int>&)> sort;
+        bool quadratic = false; // skipped above Options::quadraticLimit
+        std::function<SortStats(std::vector<int>&)> count = {}; // counting variant; empty if none
+    };
+
+    struct Options {
+        int warmups = 2;
+        int repetitions = 7;
+        int maxArraysPerSet = 0;             // 0: all
+        size_t quadraticLimit = 1 << 16;
+        std::vector<std::string> algorithms; // empty: all registered
+    };
+
+    struct Result {
+        std::string set;
+        int array = 0;
+        size_t n = 0;
+        std::string algorithm;
+        double minNs = 0, p10Ns = 0, medianNs = 0, p90Ns = 0;
+        double cyclesPerElement = 0; // TSC ticks; 0 where no cycle counter is available
+        bool sorted = false;
+        std::optional<SortStats> stats;
+        std::array<double, 6> metrics{};
+    };
+
+    // Built-in algorithms first; add() appends.
+    static std::vector<Algorithm>& registry() {
+        static std::vector<Algorithm> algorithms = builtins();
+        return algorithms;
+    }
+
+    static void add(Algorithm algorithm) {
+        registry().push_back(std::move(algorithm));
+    }
+
+    // Benchmarks every set under inputRoot and writes the table to outputCsv.
+    std::vector<Result> run(const std::string& inputRoot, const std::string& outputCsv, const Options& opt) const {
+        namespace fs = std::filesystem;
+        if (!fs::exists(inputRoot)) {
+            throw std::runtime_error("Input root does not exist: " + inputRoot);
+        }
+        const std::vector<const Algorithm*> algorithms = select(opt);
+
+        std::vector<fs::path> sets;
+        for (const auto& entry : fs::recursive_directory_iterator(inputRoot)) {
+            if (!entry.is_regular_file() || entry.path().filename() != "arrays.csv") continue;
+            const std::string rel = fs::relative(entry.path(), inputRoot).generic_string();
+            if (rel.find("shards/") != std::string::npos) continue; // unfinished sharded build
+            sets.push_back(entry.path().parent_path());
+        }
+        std::sort(sets.begin(), sets.end());
+
+        if (!fs::path(outputCsv).parent_path().empty()) fs::create_directories(fs::path(outputCsv).parent_path());
+        std::ofstream ofs(outputCsv, std::ios::trunc);
+        if (!ofs) throw std::runtime_error("Cannot open output csv: " + outputCsv);
+        ofs << "set,array,n,algorithm,warmups,repetitions,min_ns,p10_ns,median_ns,p90_ns,"
+               "cycles_per_element,sorted,comparisons,moves,merge_cost,buffer_traffic,"
+               "inv,runs,rem,osc,dis,ham\n";
+
+        std::vector<Result> results;
+        for (const auto& setDir : sets) {
+            const std::string label = fs::relative(setDir, inputRoot).generic_string();
+            std::cout << "[BENCH] " << label << "\n";
+            std::ifstream in(setDir / "arrays.csv");
+            std::vector<int> row;
+            for (int a = 0; opt.maxArraysPerSet <= 0 || a < opt.maxArraysPerSet; ++a) {
+                if (!Evaluator::readNextRow(in, row)) break;
+                const std::array<double, 6> metrics = Evaluator::normMetrics(row);
+                std::vector<int> reference = row;
+                std::sort(reference.begin(), reference.end());
+
+                for (const Algorithm* alg : algorithms) {
+                    if (alg->quadratic && row.size() > opt.quadraticLimit) continue;
+                    Result r = measure(*alg, row, reference, opt);
+                    r.set = label;
+                    r.array = a;
+                    r.metrics = metrics;
+                    if (!r.sorted) std::cout << "[FAIL] " << alg->name << " on " << label << " #" << a << "\n";
+                    writeRow(ofs, r, opt);
+                    results.push_back(std::move(r));
+                }
+            }
+        }
+        std::cout << "[OK] Benchmark written to: " << outputCsv << "\n";
+        return results;
+    }
+
+    // Warmups, then timed repetitions of one algorithm on one array.
+    static Result measure(const Algorithm& alg, const std::vector<int>& input,
+                          const std::vector<int>& reference, const Options& opt) {
+        std::vector<int> work;
+        for (int w = 0; w < opt.warmups; ++w) {
+            work = input;
+            alg.sort(work);
+        }
+
+        const int reps = std::max(1, opt.repetitions);
+        std::vector<double> ns(reps);
+        std::vector<double> cycles(reps);
+        for (int r = 0; r < reps; ++r) {
+            work = input;
+            const auto t0 = std::chrono::steady_clock::now();
+            const std::uint64_t c0 = cycleCounter();
+            alg.sort(work);
+            const std::uint64_t c1 = cycleCounter();
+            const auto t1 = std::chrono::steady_clock::now();
+            ns[r] = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            cycles[r] = static_cast<double>(c1 - c0);
+        }
+
+        Result res;
+        res.n = input.size();
+        res.algorithm = alg.name;
+        res.sorted = work == reference;
+        res.minNs = percentile(ns, 0.0);
+        res.p10Ns = percentile(ns, 0.1);
+        res.medianNs = percentile(ns, 0.5);
+        res.p90Ns = percentile(ns, 0.9);
+        res.cyclesPerElement = percentile(cycles, 0.5) / static_cast<double>(std::max<size_t>(1, input.size()));
+        if (alg.count) {
+            work = input;
+            res.stats = alg.count(work);
+            res.sorted = res.sorted && work == reference;
+        }
+        return res;
+    }
+
+    // Nearest-rank percentile, q in [0, 1].
+    static double percentile(std::vector<double> values, double q) {
+        if (values.empty()) return 0.0;
+        const size_t rank = static_cast<size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+private:
+    static std::uint64_t cycleCounter() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // One sort object per registered algorithm, reused by every timed repetition (as for
+    // PowerSort), so construction and buffer growth stay out of the timings.
+    template <template <class> class Sort>
+    static Algorithm instrumented(std::string name, bool quadratic = false) {
+        return {std::move(name),
+                [s = std::make_shared<Sort<NullCounter>>()](std::vector<int>& a) { s->sort(a); },
+                quadratic,
+                [](std::vector<int>& a) { return Sort<CountingCounter>().sort(a); }};
+    }
+
+    static std::vector<Algorithm> builtins() {
+        return {
+            {"std::sort",           [](std::vector<int>& a) { std::sort(a.begin(), a.end()); }},
+            {"std::stable_sort",    [](std::vector<int>& a) { std::stable_sort(a.begin(), a.end()); }},
+            {"gfx::timsort",        [](std::vector<int>& a) { gfx::timsort(a.begin(), a.end()); }},
+            {"PowerSort",           [ps = std::make_shared<PowerSort<>>()](std::vector<int>& a) { ps->sort(a); },
+                                    false,
+                                    [](std::vector<int>& a) { return PowerSort<int, CountingCounter>().sort(a); }},
+            {"ParallelPowerSort",   [ps = std::make_shared<PowerSort<>>()](std::vector<int>& a) { ps->sortParallel(a); },
+                                    false,
+                                    [](std::vector<int>& a) { return PowerSort<int, CountingCounter>().sortParallel(a); }},
+            instrumented<AdaptiveShiversSort>("AdaptiveShiversSort"),
+            instrumented<MergeSort>("MergeSort"),
+            instrumented<QuickSort>("QuickSort"),
+            instrumented<InsertionSort>("InsertionSort", true),
+            instrumented<BinaryInsertionSort>("BinaryInsertionSort", true),
+        };
+    }
+
+    static std::vector<const Algorithm*> select(const Options& opt) {
+        std::vector<const Algorithm*> out;
+        for (const auto& alg : registry()) {
+            if (opt.algorithms.empty()
+                || std::find(opt.algorithms.begin(), opt.algorithms.end(), alg.name) != opt.algorithms.end()) {
+                out.push_back(&alg);
+            }
+        }
+        for (const auto& name : opt.algorithms) {
+            const bool known = std::any_of(registry().begin(), registry().end(),
+                                           [&](const Algorithm& a) { return a.name == name; });
+            if (!known) throw std::invalid_argument("Unknown algorithm: " + name);
+        }
+        return out;
+    }
+
+    static void writeRow(std::ofstream& ofs, const Result& r, const Options& opt) {
+        ofs << r.set << ',' << r.array << ',' << r.n << ',' << r.algorithm << ','
+            << opt.warmups << ',' << std::max(1, opt.repetitions) << ','
+            << r.minNs << ',' << r.p10Ns << ',' << r.medianNs << ',' << r.p90Ns << ','
+            << r.cyclesPerElement << ',' << (r.sorted ? 1 : 0) << ',';
+        if (r.stats) {
+            ofs << r.stats->comparisons << ',' << r.stats->moves << ','
+                << r.stats->mergeCost << ',' << r.stats->bufferTraffic;
+        } else {
+            ofs << ",,,";
+        }
+        for (double m : r.metrics) ofs << ',' << m;
+        ofs << '\n';
+    }
+};
+
+#endif //SORTBENCHMARK_H
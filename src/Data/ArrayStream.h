@@ -0,0 +1,499 @@
+
+
+#ifndef ARRAYSTREAM_H
+#define ARRAYSTREAM_H
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "ArrayType.h"
+#include "DataGenerator.h"
+#include "IndexSelector.h"
+
+
+// Chunked generation of one array with memory independent of its length: values are
+// produced front to back into caller-sized chunks and handed to a sink (file writer,
+// ReservoirSampler::pushRange, ...). Streams are seeded and deterministic; they follow the
+// same value rules as DataGenerator but not its exact random sequence.
+class ArrayStream {
+public:
+    explicit ArrayStream(size_t size) : total(size) {}
+    virtual ~ArrayStream() = default;
+
+    // Fills the front of `out` with the next values; returns how many (0 once exhausted).
+    size_t next(std::span<int> out) {
+        const size_t n = std::min(out.size(), total - produced);
+        if (n > 0) fill(out.first(n));
+        produced += n;
+        return n;
+    }
+
+    // sink(std::span<const int>) is called once per chunk of at most chunkSize values.
+    template <class Sink>
+    void drain(size_t chunkSize, Sink&& sink) {
+        std::vector<int> buffer(std::max<size_t>(1, chunkSize));
+        while (const size_t got = next(buffer)) {
+            sink(std::span<const int>(buffer.data(), got));
+        }
+    }
+
+    size_t size() const { return total; }
+    size_t remaining() const { return total - produced; }
+
+    // Same parameters as DataGenerator::generate_Data; workload types take their parameter as
+    // k. Every ArrayType but INTERLEAVED_ARRAY has a stream.
+    static std::unique_ptr<ArrayStream> make(ArrayType type, size_t size, int minValue, int maxValue,
+                                             int runs, int k, std::uint64_t seed);
+
+protected:
+    // `out` never extends past the end of the array.
+    virtual void fill(std::span<int> out) = 0;
+
+    size_t produced = 0;
+
+private:
+    size_t total;
+};
+
+
+// Permutation of 1..n: position i maps through a keyed Feistel network over the next
+// power-of-four domain, cycle-walking until the result is below n (< 4 rounds expected).
+class PermutationStream : public ArrayStream {
+public:
+    PermutationStream(size_t size, std::uint64_t seed) : ArrayStream(size) {
+        while ((std::uint64_t(1) << (2 * halfBits)) < size) ++halfBits;
+        mask = (std::uint64_t(1) << halfBits) - 1;
+        for (auto& k : keys) {
+            seed = DataGenerator::substreamSeed(seed, 0);
+            k = seed;
+        }
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (size_t j = 0; j < out.size(); ++j) {
+            std::uint64_t x = produced + j;
+            do { x = encrypt(x); } while (x >= size());
+            out[j] = static_cast<int>(x + 1);
+        }
+    }
+
+private:
+    static constexpr int ROUNDS = 6;
+    int halfBits = 1;
+    std::uint64_t mask = 1;
+    std::uint64_t keys[ROUNDS]{};
+
+    std::uint64_t encrypt(std::uint64_t x) const {
+        std::uint64_t left = x >> halfBits;
+        std::uint64_t right = x & mask;
+        for (std::uint64_t key : keys) {
+            const std::uint64_t mixed = left ^ (DataGenerator::substreamSeed(key, right) & mask);
+            left = right;
+            right = mixed;
+        }
+        return (left << halfBits) | right;
+    }
+};
+
+
+// Values drawn uniformly from a pool of k distinct values (O(k) memory).
+class RandomStream : public ArrayStream {
+public:
+    RandomStream(size_t size, int minValue, int maxValue, int k, std::uint64_t seed)
+        : ArrayStream(size), gen(static_cast<std::uint32_t>(seed)) {
+        DataGenerator poolGen(DataGenerator::substreamSeed(seed, 0));
+        pool = poolGen.chooseDistinctValues(minValue, maxValue, k);
+        pick = std::uniform_int_distribution<size_t>(0, pool.size() - 1);
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (auto& v : out) v = pool[pick(gen)];
+    }
+
+private:
+    std::mt19937 gen;
+    std::vector<int> pool;
+    std::uniform_int_distribution<size_t> pick;
+};
+
+
+// Strictly monotone walk, as DataGenerator::generateSorted / generateReverseSorted.
+class MonotoneStream : public ArrayStream {
+public:
+    MonotoneStream(size_t size, int minValue, int maxValue, bool descending, std::uint64_t seed)
+        : ArrayStream(size), minValue(minValue), maxValue(maxValue), descending(descending),
+          gen(static_cast<std::uint32_t>(seed)) {}
+
+protected:
+    void fill(std::span<int> out) override {
+        for (size_t j = 0; j < out.size(); ++j) {
+            const long long i = static_cast<long long>(produced + j);
+            if (i == 0) {
+                std::uniform_int_distribution<long long> firstDist =
+                    descending ? std::uniform_int_distribution<long long>(static_cast<long long>(0.7 * minValue), maxValue)
+                               : std::uniform_int_distribution<long long>(minValue, static_cast<long long>(0.3 * maxValue));
+                current = firstDist(gen);
+            } else {
+                const long long left = static_cast<long long>(size()) - i;
+                const long long room = descending ? current - minValue : maxValue - current;
+                std::uniform_int_distribution<long long> stepDist(1, std::max(room / left, 1LL));
+                current += descending ? -stepDist(gen) : stepDist(gen);
+            }
+            out[j] = static_cast<int>(current);
+        }
+    }
+
+private:
+    long long minValue;
+    long long maxValue;
+    bool descending;
+    std::mt19937 gen;
+    long long current = 0;
+};
+
+
+// Exactly runsCount ascending runs, as DataGenerator::generateRuns. Run lengths are a uniform
+// composition drawn gap by gap (selection sampling); a run's lowest admissible last value only
+// depends on the chain of singleton runs right after it, which is looked ahead as a count.
+// Requires maxValue - minValue >= runsCount - 1, which covers every composition.
+class RunsStream : public ArrayStream {
+public:
+    RunsStream(size_t size, size_t runsCount, int minValue, int maxValue, std::uint64_t seed)
+        : ArrayStream(size), minValue(minValue), maxValue(maxValue), gen(static_cast<std::uint32_t>(seed)),
+          gapsLeft(size > 0 ? static_cast<long long>(size) - 1 : 0),
+          cutsLeft(runsCount > 0 ? static_cast<long long>(runsCount) - 1 : 0),
+          runsUndrawn(static_cast<long long>(runsCount)), upper(maxValue) {
+        if ((size == 0) != (runsCount == 0) || runsCount > size) {
+            throw std::invalid_argument("runsCount must be in [1, size]");
+        }
+        if (static_cast<long long>(maxValue) - minValue < static_cast<long long>(runsCount) - 1) {
+            throw std::invalid_argument("Value range too small for the requested runs");
+        }
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (auto& v : out) {
+            if (runPos == runLen) startRun();
+            if (runPos == 0) {
+                current = first;
+            } else if (runPos + 1 == runLen) {
+                current = last;
+            } else {
+                const long long slots = runLen - runPos;
+                const long long maxStep = (last - current) / slots;
+                std::uniform_int_distribution<long long> distStep(maxStep > 0 ? 1 : 0, maxStep);
+                current += distStep(gen);
+            }
+            v = static_cast<int>(current);
+            ++runPos;
+        }
+    }
+
+private:
+    long long minValue;
+    long long maxValue;
+    std::mt19937 gen;
+
+    long long gapsLeft;
+    long long cutsLeft;
+    long long runsUndrawn;
+    long long pendingSingles = 0; // drawn singleton runs following the current one
+    long long pendingLong = 0;    // drawn run of length >= 2 after those singletons (0: none)
+
+    long long upper;              // bound for the first value of the next run
+    long long runLen = 0;
+    long long runPos = 0;
+    long long first = 0;
+    long long last = 0;
+    long long current = 0;
+
+    long long drawLength() {
+        --runsUndrawn;
+        long long len = 1;
+        while (gapsLeft > 0) {
+            std::uniform_int_distribution<long long> dist(0, gapsLeft - 1);
+            const bool cut = dist(gen) < cutsLeft;
+            --gapsLeft;
+            if (cut) {
+                --cutsLeft;
+                break;
+            }
+            ++len;
+        }
+        return len;
+    }
+
+    void startRun() {
+        if (pendingSingles > 0) {
+            runLen = 1;
+            --pendingSingles;
+        } else if (pendingLong > 0) {
+            runLen = pendingLong;
+            pendingLong = 0;
+        } else {
+            runLen = drawLength();
+        }
+        while (pendingLong == 0 && runsUndrawn > 0) {
+            const long long len = drawLength();
+            if (len == 1) ++pendingSingles;
+            else pendingLong = len;
+        }
+        const long long minLast = minValue + pendingSingles + (pendingLong > 0 ? 1 : 0);
+
+        if (runLen == 1) {
+            std::uniform_int_distribution<long long> distValue(minLast, upper);
+            first = last = distValue(gen);
+        } else {
+            std::uniform_int_distribution<long long> distFirst(minValue, upper);
+            first = distFirst(gen);
+            std::uniform_int_distribution<long long> distLast(std::max(first, minLast), maxValue);
+            last = distLast(gen);
+        }
+        upper = last - 1;
+        runPos = 0;
+    }
+};
+
+
+// 1..n after `swaps` transpositions of distinct positions, as DataGenerator::generateNearlySorted.
+// Only the displaced positions are stored (O(swaps) memory).
+class NearlySortedStream : public ArrayStream {
+public:
+    NearlySortedStream(size_t size, size_t swaps, std::uint64_t seed) : ArrayStream(size) {
+        if (size < 2) return;
+        std::mt19937 gen(static_cast<std::uint32_t>(seed));
+        std::uniform_int_distribution<size_t> distPos(0, size - 1);
+        std::uniform_int_distribution<size_t> distOther(0, size - 2);
+        auto at = [&](size_t i) { return displaced.try_emplace(i, static_cast<int>(i) + 1).first; };
+        for (size_t s = 0; s < swaps; ++s) {
+            const size_t i = distPos(gen);
+            size_t j = distOther(gen);
+            if (j >= i) ++j;
+            const auto a = at(i);
+            const auto b = at(j);
+            std::swap(a->second, b->second);
+        }
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (size_t j = 0; j < out.size(); ++j) {
+            const size_t i = produced + j;
+            const auto it = displaced.find(i);
+            out[j] = it == displaced.end() ? static_cast<int>(i) + 1 : it->second;
+        }
+    }
+
+private:
+    std::unordered_map<size_t, int> displaced;
+};
+
+
+// 1..n without `tail` random values, then those values shuffled, as
+// DataGenerator::generateSortedWithTail (O(tail) memory).
+class SortedTailStream : public ArrayStream {
+public:
+    SortedTailStream(size_t size, size_t tail, std::uint64_t seed) : ArrayStream(size) {
+        if (tail > size) throw std::invalid_argument("tail must not exceed size");
+        std::mt19937 gen(static_cast<std::uint32_t>(seed));
+        chosen.reserve(tail);
+        IndexSelector::selectSorted(1, static_cast<int>(size) + 1, static_cast<int>(tail), gen,
+                                    [&](int v) { chosen.push_back(v); });
+        shuffled = chosen;
+        std::shuffle(shuffled.begin(), shuffled.end(), gen);
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (auto& v : out) {
+            if (frontLeft() > 0) {
+                while (skip < chosen.size() && chosen[skip] == next) ++next, ++skip;
+                v = next++;
+                ++front;
+            } else {
+                v = shuffled[back++];
+            }
+        }
+    }
+
+private:
+    std::vector<int> chosen;   // tail values, ascending
+    std::vector<int> shuffled; // tail values, in output order
+    size_t skip = 0;
+    size_t front = 0;
+    size_t back = 0;
+    int next = 1;
+
+    size_t frontLeft() const { return size() - chosen.size() - front; }
+};
+
+
+// Teeth 1..period entered at a random phase, as DataGenerator::generateSawtooth.
+class SawtoothStream : public ArrayStream {
+public:
+    SawtoothStream(size_t size, size_t period, std::uint64_t seed) : ArrayStream(size), period(period) {
+        if (period == 0) throw std::invalid_argument("period must be positive");
+        std::mt19937 gen(static_cast<std::uint32_t>(seed));
+        phase = std::uniform_int_distribution<size_t>(0, period - 1)(gen);
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (size_t j = 0; j < out.size(); ++j) {
+            out[j] = static_cast<int>((produced + j + phase) % period) + 1;
+        }
+    }
+
+private:
+    size_t period;
+    size_t phase = 0;
+};
+
+
+// Organ pipes with random peaks, as DataGenerator::generateOrganPipe; each pipe's peak is
+// drawn when the stream enters it.
+class OrganPipeStream : public ArrayStream {
+public:
+    OrganPipeStream(size_t size, size_t pipes, std::uint64_t seed)
+        : ArrayStream(size), pipes(pipes), gen(static_cast<std::uint32_t>(seed)) {
+        if (pipes == 0) throw std::invalid_argument("pipes must be positive");
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (size_t j = 0; j < out.size(); ++j) {
+            const size_t i = produced + j;
+            while (i >= hi) {
+                lo = pipe * size() / pipes;
+                hi = (pipe + 1) * size() / pipes;
+                ++pipe;
+                if (lo < hi) peak = DataGenerator::organPipePeak(lo, hi, gen);
+            }
+            out[j] = static_cast<int>(i <= peak ? i - lo + 1 : hi - i);
+        }
+    }
+
+private:
+    size_t pipes;
+    std::mt19937 gen;
+    size_t pipe = 0;
+    size_t lo = 0;
+    size_t hi = 0;
+    size_t peak = 0;
+};
+
+
+// Zipf-distributed draws from a shuffled pool of k distinct values, as
+// DataGenerator::generateZipf with exponent 1 (O(k) memory).
+class ZipfStream : public ArrayStream {
+public:
+    ZipfStream(size_t size, int minValue, int maxValue, int k, std::uint64_t seed)
+        : ArrayStream(size), gen(static_cast<std::uint32_t>(seed)) {
+        DataGenerator poolGen(DataGenerator::substreamSeed(seed, 0));
+        pool = poolGen.chooseDistinctValues(minValue, maxValue, k);
+        std::shuffle(pool.begin(), pool.end(), gen);
+        std::vector<double> weights(pool.size());
+        for (size_t r = 0; r < weights.size(); ++r) weights[r] = 1.0 / static_cast<double>(r + 1);
+        rank = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    }
+
+protected:
+    void fill(std::span<int> out) override {
+        for (auto& v : out) v = pool[rank(gen)];
+    }
+
+private:
+    std::mt19937 gen;
+    std::vector<int> pool;
+    std::discrete_distribution<size_t> rank;
+};
+
+
+inline std::unique_ptr<ArrayStream> ArrayStream::make(ArrayType type, size_t size, int minValue, int maxValue,
+                                                      int runs, int k, std::uint64_t seed) {
+    switch (type) {
+        case ArrayType::PERMUTATION_ARRAY:
+            return std::make_unique<PermutationStream>(size, seed);
+        case ArrayType::RANDOM_ARRAY:
+            return std::make_unique<RandomStream>(size, minValue, maxValue, k, seed);
+        case ArrayType::SORTED_ARRAY:
+            return std::make_unique<MonotoneStream>(size, minValue, maxValue, false, seed);
+        case ArrayType::REVERSE_ARRAY:
+            return std::make_unique<MonotoneStream>(size, minValue, maxValue, true, seed);
+        case ArrayType::RUNS_ARRAY:
+            return std::make_unique<RunsStream>(size, static_cast<size_t>(std::max(0, runs)), minValue, maxValue, seed);
+        default:
+            break;
+    }
+    // workloads take their parameter as k
+    if (k < 0) throw std::invalid_argument("Workload parameter must be non-negative");
+    const size_t p = static_cast<size_t>(k);
+    switch (type) {
+        case ArrayType::NEARLY_SORTED_ARRAY:
+            return std::make_unique<NearlySortedStream>(size, p, seed);
+        case ArrayType::SORTED_TAIL_ARRAY:
+            return std::make_unique<SortedTailStream>(size, p, seed);
+        case ArrayType::SAWTOOTH_ARRAY:
+            return std::make_unique<SawtoothStream>(size, p, seed);
+        case ArrayType::ORGAN_PIPE_ARRAY:
+            return std::make_unique<OrganPipeStream>(size, p, seed);
+        case ArrayType::ZIPF_ARRAY:
+            return std::make_unique<ZipfStream>(size, minValue, maxValue, k, seed);
+        default:
+            break;
+    }
+    // INTERLEAVED_ARRAY deals the values 1..n in increasing order to random sequences, so a
+    // position's value depends on the whole deal and cannot be produced front to back.
+    throw std::invalid_argument("No streaming generator for this ArrayType");
+}
+
+
+// Chunk sinks for ArrayStream::drain.
+
+// One CSV row per array (arrays.csv layout); call endRow() after the last chunk.
+class CsvRowSink {
+public:
+    explicit CsvRowSink(std::ostream& os) : os(os) {}
+
+    void operator()(std::span<const int> chunk) {
+        for (int v : chunk) {
+            if (!firstInRow) os << ',';
+            os << v;
+            firstInRow = false;
+        }
+    }
+
+    void endRow() {
+        os << '\n';
+        firstInRow = true;
+    }
+
+private:
+    std::ostream& os;
+    bool firstInRow = true;
+};
+
+// Raw native-endian int32 values.
+class BinarySink {
+public:
+    explicit BinarySink(std::ostream& os) : os(os) {}
+
+    void operator()(std::span<const int> chunk) {
+        os.write(reinterpret_cast<const char*>(chunk.data()),
+                 static_cast<std::streamsize>(chunk.size() * sizeof(int)));
+    }
+
+private:
+    std::ostream& os;
+};
+
+#endif //ARRAYSTREAM_H
@@ -10,7 +10,15 @@ enum class ArrayType {
     RANDOM_ARRAY,
     SORTED_ARRAY,
     REVERSE_ARRAY,
-    RUNS_ARRAY
+    RUNS_ARRAY,
+
+    // sort-benchmark shapes; each takes one integer parameter (see DataGenerator::generateWorkload)
+    NEARLY_SORTED_ARRAY,   // sorted, then `param` random swaps
+    SORTED_TAIL_ARRAY,     // sorted prefix followed by `param` random elements
+    SAWTOOTH_ARRAY,        // (i + phase) % param + 1, random phase in [0, param)
+    ORGAN_PIPE_ARRAY,      // `param` ascending-then-descending pipes
+    ZIPF_ARRAY,            // `param` distinct values with Zipf(1) frequencies
+    INTERLEAVED_ARRAY      // `param` sorted sequences dealt round-robin
 };
 
 #endif //ARRAYTYPE_H
@@ -1,36 +1,77 @@
 
 
 #include "DataGenerator.h"
+#include "IndexSelector.h"
+#include "ParallelShuffle.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
+#include <thread>
 #include <unordered_set>
 
 DataGenerator::DataGenerator()
-    : rng(std::random_device{}())
+    : rng(std::random_device{}()), threads(std::max(1u, std::thread::hardware_concurrency()))
 {}
 
+DataGenerator::DataGenerator(std::uint64_t seed)
+    : threads(std::max(1u, std::thread::hardware_concurrency()))
+{
+    std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    rng.seed(seq);
+}
+
+std::uint64_t DataGenerator::substreamSeed(std::uint64_t master, std::uint64_t stream) {
+    std::uint64_t z = master + (stream + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
 void DataGenerator::generate_Data(ArrayType type, int size, int minValue, int maxValue, int runs, int k) {
+    generate(type, input, static_cast<size_t>(std::max(0, size)), minValue, maxValue, runs, k);
+}
+
+void DataGenerator::generate(ArrayType type, std::vector<int>& buffer, size_t size,
+                             int minValue, int maxValue, int runs, int k) {
+    // zero runs is the empty array, as generateRuns(size, 0, ...) returns
+    if (type == ArrayType::RUNS_ARRAY && runs <= 0) size = 0;
+    // keeps the buffer's capacity: regenerating the same size never reallocates
+    buffer.resize(size);
+    generate(type, std::span<int>(buffer), minValue, maxValue, runs, k);
+}
+
+void DataGenerator::generate(ArrayType type, std::span<int> out, int minValue, int maxValue, int runs, int k) {
     switch (type) {
         case ArrayType::PERMUTATION_ARRAY: {
-            input = generatePermutation(size);
+            generatePermutation(out);
             break;
         }
         case ArrayType::RANDOM_ARRAY: {
-            input = generateRandom(size, minValue, maxValue, k);
+            generateRandom(out, minValue, maxValue, k);
             break;
         }
         case ArrayType::SORTED_ARRAY: {
-            input = generateSorted(size, minValue, maxValue);
+            generateSorted(out, minValue, maxValue);
             break;
         }
         case ArrayType::REVERSE_ARRAY: {
-            input = generateReverseSorted(size, minValue, maxValue);
+            generateReverseSorted(out, minValue, maxValue);
             break;
         }
         case ArrayType::RUNS_ARRAY: {
-            input = generateRuns(size, runs, minValue, maxValue);
+            generateRuns(out, static_cast<size_t>(std::max(0, runs)), minValue, maxValue);
+            break;
+        }
+        case ArrayType::NEARLY_SORTED_ARRAY:
+        case ArrayType::SORTED_TAIL_ARRAY:
+        case ArrayType::SAWTOOTH_ARRAY:
+        case ArrayType::ORGAN_PIPE_ARRAY:
+        case ArrayType::ZIPF_ARRAY:
+        case ArrayType::INTERLEAVED_ARRAY: {
+            generateWorkload(type, out, minValue, maxValue, k);
             break;
         }
         default: {
@@ -49,293 +90,506 @@ void DataGenerator::printArray(const std::vector<int>& arr) {
     std::cout << std::endl;
 }
 
-
 std::vector<int> DataGenerator::generatePermutation(size_t size) {
     std::vector<int> data(size);
-    std::iota(data.begin(), data.end(), 1);
+    generatePermutation(data);
+    return data;
+}
 
-    std::shuffle(data.begin(), data.end(), rng);
+void DataGenerator::generatePermutation(std::span<int> out) {
+    std::iota(out.begin(), out.end(), 1);
+    if (out.size() < ParallelShuffle::MIN_PARALLEL) {
+        std::shuffle(out.begin(), out.end(), rng);
+        return;
+    }
+    const std::uint64_t seed = (static_cast<std::uint64_t>(rng()) << 32) | rng();
+    ParallelShuffle::shuffle(out, seed, threads);
+}
 
-    return data;
+void DataGenerator::setThreads(unsigned count) {
+    threads = std::max(1u, count);
 }
 
 std::vector<int> DataGenerator::generateRandom(size_t size, int minValue, int maxValue, int k) {
+    std::vector<int> data(size);
+    generateRandom(data, minValue, maxValue, k);
+    return data;
+}
 
-    int range = maxValue - minValue + 1;
+void DataGenerator::generateRandom(std::span<int> out, int minValue, int maxValue, int k) {
+    if (out.empty()) return;
 
-    std::vector<int> pool(range);
-    std::iota(pool.begin(), pool.end(), minValue);
+    const std::vector<int> pool = chooseDistinctValues(minValue, maxValue, k);
 
-    std::shuffle(pool.begin(), pool.end(), rng);
-    pool.resize(k);
+    std::uniform_int_distribution<size_t> dist(0, pool.size() - 1);
+    for (auto& val : out) {
+        val = pool[dist(rng)];
+    }
+}
 
-    std::vector<int> data(size);
-    std::uniform_int_distribution<int> dist(0, k - 1);
+std::vector<int> DataGenerator::chooseDistinctValues(int minValue, int maxValue, int k) {
+    const long long range = static_cast<long long>(maxValue) - static_cast<long long>(minValue) + 1LL;
+    if (k <= 0 || range <= 0 || k > range) {
+        throw std::invalid_argument("Need 0 < k <= maxValue - minValue + 1");
+    }
 
-    for (auto& val : data) {
-        val = pool[dist(rng)];
+    // Floyd's sampling: for j in [range-k, range) draw t in [0, j]; take t, or j if t is taken.
+    std::unordered_set<long long> chosen;
+    chosen.reserve(static_cast<size_t>(k) * 2);
+    std::vector<int> pool;
+    pool.reserve(k);
+    for (long long j = range - k; j < range; ++j) {
+        std::uniform_int_distribution<long long> dist(0, j);
+        const long long t = dist(rng);
+        const long long pickOffset = chosen.insert(t).second ? t : j;
+        if (pickOffset == j) chosen.insert(j);
+        pool.push_back(static_cast<int>(static_cast<long long>(minValue) + pickOffset));
     }
 
-    return data;
+    return pool;
 }
 
 std::vector<int> DataGenerator::generateSorted(size_t size, int minValue, int maxValue) {
     std::vector<int> data(size);
-    if (size == 0) return data;
+    generateSorted(data, minValue, maxValue);
+    return data;
+}
+
+void DataGenerator::generateSorted(std::span<int> out, int minValue, int maxValue) {
+    const size_t size = out.size();
+    if (size == 0) return;
 
     std::uniform_int_distribution<int> firstDist(minValue, static_cast<int>(0.3 * maxValue));
-    data[0] = firstDist(rng);
+    out[0] = firstDist(rng);
 
     for (size_t i = 1; i < size; ++i) {
-        int maxStep = (maxValue - data[i - 1]) / static_cast<int>(size - i);
+        int maxStep = (maxValue - out[i - 1]) / static_cast<int>(size - i);
         maxStep = std::max(maxStep, 1);
         std::uniform_int_distribution<int> stepDist(1, maxStep);
-        data[i] = data[i - 1] + stepDist(rng);
+        out[i] = out[i - 1] + stepDist(rng);
     }
-
-    return data;
 }
 
 std::vector<int> DataGenerator::generateReverseSorted(size_t size, int minValue, int maxValue) {
     std::vector<int> data(size);
-    if (size == 0) return data;
+    generateReverseSorted(data, minValue, maxValue);
+    return data;
+}
+
+void DataGenerator::generateReverseSorted(std::span<int> out, int minValue, int maxValue) {
+    const size_t size = out.size();
+    if (size == 0) return;
 
     std::uniform_int_distribution<int> firstDist(static_cast<int>(0.7 * minValue), maxValue);
-    data[0] = firstDist(rng);
+    out[0] = firstDist(rng);
 
     for (size_t i = 1; i < size; ++i) {
-        int maxStep = (data[i - 1] - minValue) / static_cast<int>(size - i);
+        int maxStep = (out[i - 1] - minValue) / static_cast<int>(size - i);
         maxStep = std::max(maxStep, 1);
         std::uniform_int_distribution<int> stepDist(1, maxStep);
-        data[i] = data[i - 1] - stepDist(rng);
+        out[i] = out[i - 1] - stepDist(rng);
     }
-
-    return data;
 }
 
-
-
 std::vector<int> DataGenerator::generateRuns(size_t size, size_t runsCount, int minValue, int maxValue) {
     std::vector<int> data;
     if (runsCount == 0 || size == 0) return data;
+    data.resize(size);
+    generateRuns(data, runsCount, minValue, maxValue);
+    return data;
+}
 
-    std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<int> distLength(
-        1,
-        static_cast<int>(std::max<size_t>(1, size / std::max<size_t>(runsCount, 1)))
-    );
-
+void DataGenerator::generateRuns(std::span<int> out, size_t runsCount, int minValue, int maxValue) {
+    const size_t size = out.size();
+    if (size == 0) return;
+    // only the empty array has zero runs, and a span cannot shrink to it
+    if (runsCount == 0 || runsCount > size) {
+        throw std::invalid_argument("runsCount must be in [1, size]");
+    }
 
-    const auto runLengths = buildRunLengths(size, runsCount, gen, distLength);
-    const auto runStarts  = buildRunStarts(runLengths);
+    // Run lengths are parked in the last runsCount slots: run i's values end at or before
+    // slot size-runsCount+i, so lengths of later runs are never overwritten before use.
+    const std::span<int> lengths = out.last(runsCount);
+    buildRunLengths(size, lengths);
+
+    // minLast(i): lowest value run i may end on so that every later run still fits below it;
+    // with c singleton runs right after i it is minValue + c, plus 1 if a longer run follows.
+    long long needed = minValue;
+    long long chain = 0;
+    for (size_t i = runsCount; i-- > 1;) {
+        chain = (lengths[i] == 1) ? chain + 1 : 0;
+        needed = std::max(needed, minValue + chain + (i + chain < runsCount ? 1 : 0));
+    }
+    if (needed > maxValue) {
+        throw std::invalid_argument("Value range too small for the requested runs");
+    }
 
+    size_t pos = 0;
+    size_t chainEnd = 0;        // first run after the singleton chain following the current run
+    long long upper = maxValue; // bound for the first value of the next run
     for (size_t i = 0; i < runsCount; ++i) {
-        const size_t L = runLengths[i];
-        if (L == 0) continue;
-
-        if (!ensurePrevRunFeasible(gen, i, L, runLengths, runStarts, minValue, maxValue, data)) {
-            throw std::runtime_error("Failed to regenerate previous runs to satisfy constraints");
+        const size_t L = static_cast<size_t>(lengths[i]);
+        if (chainEnd <= i) chainEnd = i + 1;
+        while (chainEnd < runsCount && lengths[chainEnd] == 1) ++chainEnd;
+        const long long minLast = minValue + static_cast<long long>(chainEnd - i - 1)
+                                  + (chainEnd < runsCount ? 1 : 0);
+
+        if (L == 1) {
+            // a singleton is its own first and last value
+            std::uniform_int_distribution<long long> distValue(minLast, upper);
+            const long long v = distValue(rng);
+            out[pos++] = static_cast<int>(v);
+            upper = v - 1;
+            continue;
         }
 
-        const bool hasPrev = !data.empty();
-        const int prevLast = hasPrev ? data.back() : std::numeric_limits<int>::max();
+        std::uniform_int_distribution<long long> distFirst(minValue, upper);
+        const long long first = distFirst(rng);
+        std::uniform_int_distribution<long long> distLast(std::max(first, minLast), maxValue);
+        const long long last = distLast(rng);
 
-        std::vector<int> runElems;
-        if (!generateRunWithRetries(gen, L, minValue, maxValue, hasPrev, prevLast, runElems, /*attempts*/100)) {
-            throw std::runtime_error("Unable to generate run with given constraints");
-        }
-
-        data.insert(data.end(), runElems.begin(), runElems.end());
+        fillAscendingRun(first, last, out.subspan(pos, L));
+        pos += L;
+        upper = last - 1;
     }
-
-    return data;
 }
 
+std::vector<int> DataGenerator::generateWithInversions(size_t size, long long inversions) {
+    const long long n = static_cast<long long>(size);
+    if (inversions < 0 || inversions > n * (n - 1) / 2) {
+        throw std::invalid_argument("inversions must be in [0, n*(n-1)/2]");
+    }
 
-bool DataGenerator::generateSingleRun(std::mt19937& gen,
-                                      size_t L,
-                                      int minValue,
-                                      int maxValue,
-                                      bool hasPrev,
-                                      int prevLast,
-                                      std::vector<int>& out)
-{
-    if (L == 0) return true;
-
-    long long hi = static_cast<long long>(maxValue) - static_cast<long long>(L) + 1LL;
-
-    if (hasPrev) {
-        hi = std::min<long long>(hi, static_cast<long long>(prevLast) - 1LL);
+    // code[i] in [0, n-1-i] and sum(code) == inversions. Positions are filled in random order,
+    // each value drawn from the range that keeps the remaining target reachable.
+    std::vector<int> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<int> code(size, 0);
+    long long remaining = inversions;
+    long long capacityLeft = n * (n - 1) / 2;
+    for (int i : order) {
+        const long long cap = n - 1 - i;
+        capacityLeft -= cap;
+        const long long lo = std::max(0LL, remaining - capacityLeft);
+        const long long hi = std::min(cap, remaining);
+        std::uniform_int_distribution<long long> dist(lo, hi);
+        code[i] = static_cast<int>(dist(rng));
+        remaining -= code[i];
     }
 
-    long long lo = minValue;
-    if (L == 1) {
+    return decodeLehmerCode(code);
+}
 
-        lo = std::max<long long>(lo, static_cast<long long>(minValue) + 1LL);
+std::vector<int> DataGenerator::decodeLehmerCode(const std::vector<int>& code) {
+    const int n = static_cast<int>(code.size());
+    // Fenwick tree over the unused values 1..n; find k-th unused by binary lifting
+    std::vector<int> tree(n + 1, 0);
+    for (int v = 1; v <= n; ++v) {
+        ++tree[v];
+        const int parent = v + (v & -v);
+        if (parent <= n) tree[parent] += tree[v];
     }
-
-    if (hi < lo) {
-        return false;
+    int topBit = 1;
+    while (topBit * 2 <= n) topBit *= 2;
+
+    std::vector<int> data(n);
+    for (int i = 0; i < n; ++i) {
+        int pos = 0;
+        int rank = code[i] + 1; // 1-based rank among unused values
+        for (int step = topBit; step > 0; step /= 2) {
+            if (pos + step <= n && tree[pos + step] < rank) {
+                pos += step;
+                rank -= tree[pos];
+            }
+        }
+        data[i] = pos + 1;
+        for (int v = pos + 1; v <= n; v += v & -v) --tree[v];
     }
+    return data;
+}
 
-    std::uniform_int_distribution<int> distStart(static_cast<int>(lo), static_cast<int>(hi));
-    int startValue = distStart(gen);
-
-    int current = startValue;
-    int remainingLength = static_cast<int>(L);
-    int remainingRange  = std::max(0, maxValue - current);
-
-    for (size_t j = 0; j < L; ++j) {
-        out.push_back(current);
-        --remainingLength;
-
-        if (remainingLength > 0) {
+std::vector<int> DataGenerator::generateWithRem(size_t size, size_t rem) {
+    if (size == 0 && rem == 0) return {};
+    if (rem < 1 || rem > size) {
+        throw std::invalid_argument("rem must be in [1, size]");
+    }
 
-            int maxPossibleStep = std::max(1, remainingRange / remainingLength);
-            std::uniform_int_distribution<int> distStep(1, maxPossibleStep);
-            int step = distStep(gen);
+    // band[i]: value band of position i. Values rise from band to band and fall within a band,
+    // so an increasing subsequence holds at most one element per band; the chain of one
+    // position per band, in position order, reaches exactly `rem`.
+    std::vector<int> band(size);
+    std::uniform_int_distribution<int> distBand(0, static_cast<int>(rem) - 1);
+    for (auto& b : band) b = distBand(rng);
+    int chainBand = 0;
+    IndexSelector::selectSorted(0, static_cast<int>(size), static_cast<int>(rem), rng,
+                                [&](int pos) { band[pos] = chainBand++; });
 
-            long long nextVal = static_cast<long long>(current) + static_cast<long long>(step);
-            if (nextVal > maxValue) nextVal = maxValue;
+    std::vector<int> nextValue(rem + 1, 0); // top value of each band, handed out downwards
+    for (int b : band) ++nextValue[b + 1];
+    for (size_t b = 1; b <= rem; ++b) nextValue[b] += nextValue[b - 1];
 
-            current = static_cast<int>(nextVal);
-            remainingRange = std::max(0, maxValue - current);
-        }
+    std::vector<int> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = nextValue[band[i] + 1]--;
     }
-
-    return true;
+    return data;
 }
 
-bool DataGenerator::regeneratePreviousRun(std::mt19937& gen,
-                                          size_t k,
-                                          const std::vector<size_t>& runLengths,
-                                          const std::vector<size_t>& runStarts,
-                                          int minValue,
-                                          int maxValue,
-                                          std::vector<int>& data)
-{
-    const size_t L        = runLengths[k];
-    const size_t startIdx = runStarts[k];
-
-    data.erase(data.begin() + static_cast<long long>(startIdx),
-               data.begin() + static_cast<long long>(startIdx) + static_cast<long long>(L));
+std::vector<int> DataGenerator::generateWithOsc(size_t size, size_t osc) {
+    if (osc > (size < 3 ? 0 : size - 2)) {
+        throw std::invalid_argument("osc must be in [0, size-2]");
+    }
+    if (size == 0) return {};
+
+    // up[k]: direction between positions k and k+1; it flips at exactly `osc` interior positions
+    std::vector<char> up(size > 1 ? size - 1 : 0);
+    bool dir = std::bernoulli_distribution(0.5)(rng);
+    size_t k = 0;
+    auto fillTo = [&](size_t end) {
+        for (; k < end; ++k) up[k] = dir;
+    };
+    IndexSelector::selectSorted(1, static_cast<int>(size) - 1, static_cast<int>(osc), rng, [&](int turn) {
+        fillTo(static_cast<size_t>(turn));
+        dir = !dir;
+    });
+    fillTo(up.size());
+
+    // a random walk with those step directions; its ranks keep every adjacent comparison
+    std::vector<long long> walk(size, 0);
+    std::uniform_int_distribution<long long> distStep(1, static_cast<long long>(size));
+    for (size_t i = 1; i < size; ++i) {
+        const long long step = distStep(rng);
+        walk[i] = walk[i - 1] + (up[i - 1] ? step : -step);
+    }
 
+    std::vector<int> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return walk[a] != walk[b] ? walk[a] < walk[b] : a < b;
+    });
+    std::vector<int> data(size);
+    for (size_t r = 0; r < size; ++r) data[order[r]] = static_cast<int>(r) + 1;
+    return data;
+}
 
-    const bool hasPrev2 = (k > 0);
-    int prevLast2 = 0;
-    if (hasPrev2) {
-        const size_t endIdxPrev2 = startIdx - 1;
-        prevLast2 = data[endIdxPrev2];
+std::vector<int> DataGenerator::generateWithMaxDisplacement(size_t size, size_t maxDisplacement) {
+    if (size == 0 && maxDisplacement == 0) return {};
+    if (maxDisplacement >= size) {
+        throw std::invalid_argument("maxDisplacement must be in [0, size-1]");
     }
 
+    std::vector<int> data(size);
+    std::iota(data.begin(), data.end(), 1);
+    if (maxDisplacement == 0) return data;
 
-    for (int attempt = 0; attempt < 100; ++attempt) {
-        std::vector<int> candidate;
-        const bool ok = generateSingleRun(gen, L, minValue, maxValue, hasPrev2, prevLast2, candidate);
-        if (!ok) continue;
-
-        if (L == 1 && candidate[0] == minValue) continue;
+    // elements only move inside blocks of width maxDisplacement+1; one randomly placed block
+    // moves its first element to its last position to hit the bound exactly
+    const size_t width = maxDisplacement + 1;
+    std::uniform_int_distribution<size_t> distStart(0, size - width);
+    const size_t forced = distStart(rng);
 
-        data.insert(data.begin() + static_cast<long long>(startIdx), candidate.begin(), candidate.end());
-        return true;
-    }
+    auto shuffleBlocks = [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b += width) {
+            std::shuffle(data.begin() + b, data.begin() + std::min(end, b + width), rng);
+        }
+    };
+    shuffleBlocks(0, forced);
+    shuffleBlocks(forced, forced + width);
+    shuffleBlocks(forced + width, size);
+
+    const auto first = std::find(data.begin() + forced, data.begin() + forced + width,
+                                 static_cast<int>(forced) + 1);
+    std::iter_swap(first, data.begin() + forced + maxDisplacement);
+    return data;
+}
 
-    return false;
+std::vector<int> DataGenerator::generateWorkload(ArrayType type, size_t size, int minValue, int maxValue, int param) {
+    std::vector<int> data(size);
+    generateWorkload(type, data, minValue, maxValue, param);
+    return data;
 }
 
-std::vector<size_t> DataGenerator::buildRunLengths(size_t size,
-                                                   size_t runsCount,
-                                                   std::mt19937& gen,
-                                                   std::uniform_int_distribution<int>& distLength)
-{
-    std::vector<size_t> runLengths(runsCount, 0);
-    size_t total = 0;
-
-    for (size_t i = 0; i < runsCount && total < size; ++i) {
-        size_t len = static_cast<size_t>(distLength(gen));
-        if (total + len > size) len = size - total;
-        runLengths[i] = len;
-        total += len;
+void DataGenerator::generateWorkload(ArrayType type, std::span<int> out, int minValue, int maxValue, int param) {
+    if (param < 0) throw std::invalid_argument("Workload parameter must be non-negative");
+    const size_t p = static_cast<size_t>(param);
+    switch (type) {
+        case ArrayType::NEARLY_SORTED_ARRAY: generateNearlySorted(out, p); break;
+        case ArrayType::SORTED_TAIL_ARRAY:   generateSortedWithTail(out, p); break;
+        case ArrayType::SAWTOOTH_ARRAY:      generateSawtooth(out, p); break;
+        case ArrayType::ORGAN_PIPE_ARRAY:    generateOrganPipe(out, p); break;
+        case ArrayType::ZIPF_ARRAY:          generateZipf(out, minValue, maxValue, param); break;
+        case ArrayType::INTERLEAVED_ARRAY:   generateInterleaved(out, p); break;
+        default:
+            throw std::invalid_argument("Not a workload ArrayType");
     }
+}
+
+std::vector<int> DataGenerator::generateNearlySorted(size_t size, size_t swaps) {
+    std::vector<int> data(size);
+    generateNearlySorted(data, swaps);
+    return data;
+}
 
-    size_t remaining = size - total;
-    while (remaining--) {
-        size_t idx = gen() % std::max<size_t>(runsCount, 1);
-        ++runLengths[idx];
+void DataGenerator::generateNearlySorted(std::span<int> out, size_t swaps) {
+    std::iota(out.begin(), out.end(), 1);
+    if (out.size() < 2) return;
+
+    // each swap exchanges two distinct positions: j is drawn from the other n-1
+    std::uniform_int_distribution<size_t> distPos(0, out.size() - 1);
+    std::uniform_int_distribution<size_t> distOther(0, out.size() - 2);
+    for (size_t s = 0; s < swaps; ++s) {
+        const size_t i = distPos(rng);
+        size_t j = distOther(rng);
+        if (j >= i) ++j;
+        std::swap(out[i], out[j]);
     }
+}
 
-    return runLengths;
+std::vector<int> DataGenerator::generateSortedWithTail(size_t size, size_t tail) {
+    std::vector<int> data(size);
+    generateSortedWithTail(data, tail);
+    return data;
 }
 
-std::vector<size_t> DataGenerator::buildRunStarts(const std::vector<size_t>& runLengths) {
-    std::vector<size_t> runStarts(runLengths.size(), 0);
-    size_t cursor = 0;
-    for (size_t i = 0; i < runLengths.size(); ++i) {
-        runStarts[i] = cursor;
-        cursor += runLengths[i];
-    }
-    return runStarts;
+void DataGenerator::generateSortedWithTail(std::span<int> out, size_t tail) {
+    const size_t size = out.size();
+    if (tail > size) throw std::invalid_argument("tail must not exceed size");
+
+    // one merge-like scan: chosen values go to the tail, the others stay in order in front
+    size_t front = 0;
+    size_t back = size - tail;
+    int next = 1;
+    IndexSelector::selectSorted(1, static_cast<int>(size) + 1, static_cast<int>(tail), rng, [&](int v) {
+        for (; next < v; ++next) out[front++] = next;
+        out[back++] = next++;
+    });
+    for (; next <= static_cast<int>(size); ++next) out[front++] = next;
+
+    std::shuffle(out.end() - tail, out.end(), rng);
 }
 
-bool DataGenerator::needBacktrackForNextRun(size_t L,
-                                            int prevLast,
-                                            int minValue,
-                                            int maxValue)
-{
-    long long hi = static_cast<long long>(maxValue) - static_cast<long long>(L) + 1LL;
-    hi = std::min<long long>(hi, static_cast<long long>(prevLast) - 1LL);
-    long long lo = minValue;
-    return (hi < lo);
-}
-
-bool DataGenerator::generateRunWithRetries(std::mt19937& gen,
-                                           size_t L,
-                                           int minValue,
-                                           int maxValue,
-                                           bool hasPrev,
-                                           int prevLast,
-                                           std::vector<int>& out,
-                                           int attempts)
-{
-    for (int a = 0; a < attempts; ++a) {
-        out.clear();
-        if (generateSingleRun(gen, L, minValue, maxValue, hasPrev, prevLast, out)) {
-            return true;
-        }
-    }
-    return false;
+std::vector<int> DataGenerator::generateSawtooth(size_t size, size_t period) {
+    std::vector<int> data(size);
+    generateSawtooth(data, period);
+    return data;
 }
 
-bool DataGenerator::ensurePrevRunFeasible(std::mt19937& gen,
-                                          size_t currentRunIndex,
-                                          size_t L,
-                                          const std::vector<size_t>& runLengths,
-                                          const std::vector<size_t>& runStarts,
-                                          int minValue,
-                                          int maxValue,
-                                          std::vector<int>& data)
-{
-    if (data.empty()) return true;
+void DataGenerator::generateSawtooth(std::span<int> out, size_t period) {
+    if (period == 0) throw std::invalid_argument("period must be positive");
+    // random phase: the first tooth starts at a random height
+    std::uniform_int_distribution<size_t> distPhase(0, period - 1);
+    const size_t phase = distPhase(rng);
+    for (size_t i = 0; i < out.size(); ++i) out[i] = static_cast<int>((i + phase) % period) + 1;
+}
 
-    size_t k = currentRunIndex - 1;
-    while (true) {
-        const int prevLast = data.back();
-        if (!needBacktrackForNextRun(L, prevLast, minValue, maxValue)) {
-            return true;
-        }
+std::vector<int> DataGenerator::generateOrganPipe(size_t size, size_t pipes) {
+    std::vector<int> data(size);
+    generateOrganPipe(data, pipes);
+    return data;
+}
 
-        if (!regeneratePreviousRun(gen, k, runLengths, runStarts, minValue, maxValue, data)) {
-            if (k == 0) return false;
-            --k;
+void DataGenerator::generateOrganPipe(std::span<int> out, size_t pipes) {
+    if (pipes == 0) throw std::invalid_argument("pipes must be positive");
+    const size_t size = out.size();
+    // pipe j covers [j*size/pipes, (j+1)*size/pipes): rises to a peak drawn from its middle
+    // half, then falls back
+    for (size_t j = 0; j < pipes; ++j) {
+        const size_t lo = j * size / pipes;
+        const size_t hi = (j + 1) * size / pipes;
+        if (lo == hi) continue;
+        const size_t peak = organPipePeak(lo, hi, rng);
+        for (size_t i = lo; i < hi; ++i) {
+            out[i] = static_cast<int>(i <= peak ? i - lo + 1 : hi - i);
         }
-
     }
 }
 
+std::vector<int> DataGenerator::generateZipf(size_t size, int minValue, int maxValue, int k, double exponent) {
+    std::vector<int> data(size);
+    generateZipf(data, minValue, maxValue, k, exponent);
+    return data;
+}
 
+void DataGenerator::generateZipf(std::span<int> out, int minValue, int maxValue, int k, double exponent) {
+    if (out.empty()) return;
 
+    // shuffled, so the frequent values are spread over the range
+    std::vector<int> pool = chooseDistinctValues(minValue, maxValue, k);
+    std::shuffle(pool.begin(), pool.end(), rng);
+    std::vector<double> weights(pool.size());
+    for (size_t r = 0; r < weights.size(); ++r) {
+        weights[r] = 1.0 / std::pow(static_cast<double>(r + 1), exponent);
+    }
+    std::discrete_distribution<size_t> distRank(weights.begin(), weights.end());
+    for (auto& v : out) v = pool[distRank(rng)];
+}
 
+std::vector<int> DataGenerator::generateInterleaved(size_t size, size_t sequences) {
+    std::vector<int> data(size);
+    generateInterleaved(data, sequences);
+    return data;
+}
 
+void DataGenerator::generateInterleaved(std::span<int> out, size_t sequences) {
+    if (sequences == 0) throw std::invalid_argument("sequences must be positive");
+    const size_t size = out.size();
+    const size_t m = std::min(sequences, size);
+    if (m == 0) return;
+
+    // Values 1..n are dealt in increasing order; each goes to a sequence drawn with probability
+    // proportional to its free slots (a uniform random split), landing in that sequence's next
+    // slot i % sequences == j. Free slots per sequence sit in a Fenwick tree.
+    std::vector<long long> tree(m + 1, 0);
+    std::vector<size_t> filled(m, 0);
+    for (size_t j = 0; j < m; ++j) {
+        const long long slots = static_cast<long long>((size - j + sequences - 1) / sequences);
+        for (size_t t = j + 1; t <= m; t += t & (~t + 1)) tree[t] += slots;
+    }
+    size_t topBit = 1;
+    while (topBit * 2 <= m) topBit *= 2;
+
+    for (size_t v = 1; v <= size; ++v) {
+        std::uniform_int_distribution<long long> distSlot(1, static_cast<long long>(size - v + 1));
+        long long rank = distSlot(rng);
+        size_t j = 0;
+        for (size_t step = topBit; step > 0; step /= 2) {
+            if (j + step <= m && tree[j + step] < rank) {
+                j += step;
+                rank -= tree[j];
+            }
+        }
+        // j is the 0-based sequence
+        out[j + filled[j]++ * sequences] = static_cast<int>(v);
+        for (size_t t = j + 1; t <= m; t += t & (~t + 1)) --tree[t];
+    }
+}
 
+void DataGenerator::buildRunLengths(size_t size, std::span<int> lengths) {
+    // uniform composition of `size` into lengths.size() positive parts: choose the
+    // runsCount-1 cut points among the size-1 gaps between elements
+    size_t prevCut = 0;
+    size_t r = 0;
+    IndexSelector::selectSorted(1, static_cast<int>(size), static_cast<int>(lengths.size()) - 1, rng,
+                                [&](int cut) {
+                                    lengths[r++] = static_cast<int>(static_cast<size_t>(cut) - prevCut);
+                                    prevCut = static_cast<size_t>(cut);
+                                });
+    lengths[r] = static_cast<int>(size - prevCut);
+}
 
-
+void DataGenerator::fillAscendingRun(long long first, long long last, std::span<int> run) {
+    // non-decreasing walk from first to exactly last; strictly increasing when the range allows
+    const size_t L = run.size();
+    long long current = first;
+    run[0] = static_cast<int>(current);
+    for (size_t j = 1; j + 1 < L; ++j) {
+        const long long slots = static_cast<long long>(L - j);
+        const long long maxStep = (last - current) / slots;
+        std::uniform_int_distribution<long long> distStep(maxStep > 0 ? 1 : 0, maxStep);
+        current += distStep(rng);
+        run[j] = static_cast<int>(current);
+    }
+    run[L - 1] = static_cast<int>(last);
+}
@@ -3,7 +3,9 @@
 #ifndef DATAGENERATOR_H
 #define DATAGENERATOR_H
 #include <algorithm>
+#include <cstdint>
 #include <random>
+#include <span>
 #include <vector>
 
 #include "ArrayType.h"
@@ -14,22 +16,98 @@ class DataGenerator {
 public:
     DataGenerator();
 
+    // Deterministic generator: equal seeds produce equal arrays.
+    explicit DataGenerator(std::uint64_t seed);
+
+    // Seed of substream `stream` derived from `master` (SplitMix64 mixing), so that e.g.
+    // array i of a set can be regenerated on its own, on any thread.
+    static std::uint64_t substreamSeed(std::uint64_t master, std::uint64_t stream);
+
 
     std::vector<int> input;
 
+    // Regenerates `input` in place (no reallocation when the size is unchanged).
     void generate_Data(ArrayType type, int size, int minValue, int maxValue, int runs, int k);
 
+    // Fill a caller-owned buffer: `out` is overwritten with out.size() values, and `buffer`
+    // is resized to `size` and reused across calls. Parameters as in generate_Data.
+    void generate(ArrayType type, std::span<int> out, int minValue, int maxValue, int runs, int k);
+    void generate(ArrayType type, std::vector<int>& buffer, size_t size,
+                  int minValue, int maxValue, int runs, int k);
+
     void printArray(const std::vector<int>& arr);
 
+    // Every array generator also has an overload that fills a std::span<int> of the wanted size.
+
+    // Large permutations are shuffled on `threads` threads (ParallelShuffle); the result only
+    // depends on the generator's seed.
     std::vector<int> generatePermutation(size_t size);
+    void generatePermutation(std::span<int> out);
+    void setThreads(unsigned count);
 
     std::vector<int> generateRandom(size_t size, int minValue, int maxValue, int k);
+    void generateRandom(std::span<int> out, int minValue, int maxValue, int k);
+    // k distinct values from [minValue, maxValue] in O(k) time and memory (Floyd).
+    std::vector<int> chooseDistinctValues(int minValue, int maxValue, int k);
     std::vector<int> generateSorted(size_t size, int minValue, int maxValue);
+    void generateSorted(std::span<int> out, int minValue, int maxValue);
     std::vector<int> generateReverseSorted(size_t size, int minValue, int maxValue);
+    void generateReverseSorted(std::span<int> out, int minValue, int maxValue);
+    // Exactly runsCount ascending runs in one O(size) pass; run lengths are a uniform
+    // composition of size. Throws std::invalid_argument when the lengths cannot fit the range.
+    // runsCount == 0 gives the empty array (generate and generate_Data included); the span
+    // overload, which cannot shrink, throws for it unless `out` is already empty.
     std::vector<int> generateRuns(size_t size, size_t runsCount, int minValue, int maxValue);
-
-
-    std::vector<int> getInput() {
+    void generateRuns(std::span<int> out, size_t runsCount, int minValue, int maxValue);
+
+    // Permutations of 1..size with an exact value of one DisorderMetrics metric.
+    // Out-of-range targets throw std::invalid_argument.
+
+    // calculateInversions == inversions: random Lehmer code with that sum, decoded in O(n log n).
+    std::vector<int> generateWithInversions(size_t size, long long inversions);
+    // calculateRem == rem: `rem` decreasing value bands, with one increasing chain across them.
+    std::vector<int> generateWithRem(size_t size, size_t rem);
+    // calculateOsc == osc: random up/down pattern with exactly `osc` turns, realised by a walk.
+    std::vector<int> generateWithOsc(size_t size, size_t osc);
+    // calculateMax == maxDisplacement: blocks of maxDisplacement+1 shuffled in place.
+    std::vector<int> generateWithMaxDisplacement(size_t size, size_t maxDisplacement);
+
+    // Sort-benchmark shapes. All but Zipf are built on the values 1..size.
+
+    // Dispatch for the workload ArrayTypes; `param` is the per-shape parameter documented there.
+    std::vector<int> generateWorkload(ArrayType type, size_t size, int minValue, int maxValue, int param);
+    void generateWorkload(ArrayType type, std::span<int> out, int minValue, int maxValue, int param);
+
+    // 1..size after `swaps` transpositions of two distinct random positions.
+    std::vector<int> generateNearlySorted(size_t size, size_t swaps);
+    void generateNearlySorted(std::span<int> out, size_t swaps);
+    // `tail` values chosen at random and appended shuffled; the rest stay sorted in front.
+    std::vector<int> generateSortedWithTail(size_t size, size_t tail);
+    void generateSortedWithTail(std::span<int> out, size_t tail);
+    // Teeth 1..period, the first one entered at a random phase.
+    std::vector<int> generateSawtooth(size_t size, size_t period);
+    void generateSawtooth(std::span<int> out, size_t period);
+    // `pipes` equal slices, each rising from 1 to a random peak in its middle half, then falling.
+    std::vector<int> generateOrganPipe(size_t size, size_t pipes);
+    void generateOrganPipe(std::span<int> out, size_t pipes);
+
+    // Peak position of the organ pipe [lo, hi), hi > lo (shared with OrganPipeStream).
+    template <class Gen>
+    static size_t organPipePeak(size_t lo, size_t hi, Gen& gen) {
+        const size_t center = lo + (hi - lo - 1) / 2;
+        const size_t jitter = (hi - lo - 1) / 4;
+        std::uniform_int_distribution<size_t> distPeak(center - jitter, center + jitter);
+        return distPeak(gen);
+    }
+    // k distinct values from [minValue, maxValue]; the r-th most frequent has weight 1/r^exponent.
+    std::vector<int> generateZipf(size_t size, int minValue, int maxValue, int k, double exponent = 1.0);
+    void generateZipf(std::span<int> out, int minValue, int maxValue, int k, double exponent = 1.0);
+    // Position i belongs to sequence i % sequences; each sequence is ascending over random values.
+    std::vector<int> generateInterleaved(size_t size, size_t sequences);
+    void generateInterleaved(std::span<int> out, size_t sequences);
+
+
+    const std::vector<int>& getInput() const {
         return input;
     };
 
@@ -38,62 +116,14 @@ public:
 
 private:
 
-     // Generate one ascending run of length L and append it to `out`.
-    // If hasPrev == true, the run's start must be < prevLast.
-    // Values must stay within [minValue, maxValue].
-    // For L == 1, the single value must be > minValue.
-    bool generateSingleRun(std::mt19937& gen,
-                           size_t L,
-                           int minValue,
-                           int maxValue,
-                           bool hasPrev,
-                           int prevLast,
-                           std::vector<int>& out);
-
-    // Regenerate the previous run k in-place within `data` using the same length.
-    // Keeps it strictly below the run before it (if exists), and avoids L==1 at minValue.
-    bool regeneratePreviousRun(std::mt19937& gen,
-                               size_t k,
-                               const std::vector<size_t>& runLengths,
-                               const std::vector<size_t>& runStarts,
-                               int minValue,
-                               int maxValue,
-                               std::vector<int>& data);
-
-    // Build random run lengths that sum exactly to `size`.
-    std::vector<size_t> buildRunLengths(size_t size,
-                                        size_t runsCount,
-                                        std::mt19937& gen,
-                                        std::uniform_int_distribution<int>& distLength);
-
-    // Prefix sums of lengths → start indices of each run in the final array.
-    std::vector<size_t> buildRunStarts(const std::vector<size_t>& runLengths);
-
-    // Check whether the next run of length L would have an empty start interval given prevLast.
-    static bool needBacktrackForNextRun(size_t L,
-                                        int prevLast,
-                                        int minValue,
-                                        int maxValue);
-
-    // Retry wrapper around generateSingleRun to avoid rare random dead-ends.
-    bool generateRunWithRetries(std::mt19937& gen,
-                                size_t L,
-                                int minValue,
-                                int maxValue,
-                                bool hasPrev,
-                                int prevLast,
-                                std::vector<int>& out,
-                                int attempts = 100);
-
-    // Ensure the previous run(s) allow starting the current run; backtracks/regenerates if needed.
-    bool ensurePrevRunFeasible(std::mt19937& gen,
-                               size_t currentRunIndex,
-                               size_t L,
-                               const std::vector<size_t>& runLengths,
-                               const std::vector<size_t>& runStarts,
-                               int minValue,
-                               int maxValue,
-                               std::vector<int>& data);
+    // Uniformly random run lengths, each >= 1, summing exactly to `size`.
+    void buildRunLengths(size_t size, std::span<int> lengths);
+
+    // Permutation of 1..n with the given Lehmer code (code[i] = smaller elements right of i).
+    static std::vector<int> decodeLehmerCode(const std::vector<int>& code);
+
+    // Fill `run` with non-decreasing values starting at `first` and ending at `last`.
+    void fillAscendingRun(long long first, long long last, std::span<int> run);
 
 
     std::vector<int> generateRunLengths(size_t size, size_t runsCount);
@@ -102,6 +132,7 @@ private:
 
 private:
     std::mt19937 rng;
+    unsigned threads;
 };
 
 
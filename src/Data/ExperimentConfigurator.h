@@ -13,20 +13,79 @@
 #include <filesystem>
 #include <algorithm>
 #include <functional>
-
+#include <numeric>
+#include <optional>
+#include <cstdint>
+#include <exception>
+#include <random>
+#include <span>
+#include <thread>
+#include <utility>
+
+#include "ArrayStream.h"
 #include "DataGenerator.h"
+#include "MultiSampler.h"
+#include "ReservoirSampler.h"
+#include "SampleCodec.h"
+#include "SamplePyramid.h"
 #include "Sampler.h"
 
 class ExperimentConfigurator {
 public:
 
     struct Config {
+        // The required fields; everything else keeps its default below.
+        Config(int n, int sampleSize, int minValue, int maxValue, std::string root)
+            : n(n), sampleSize(sampleSize), minValue(minValue), maxValue(maxValue), root(std::move(root)) {}
+
         int n;
         int sampleSize;
         int minValue;
         int maxValue;
         std::string root;
 
+        // Every array and sample of a build derives from this seed: array i of a set is drawn
+        // from its own substream, so the output does not depend on `threads`. Unset: reuse the
+        // seed of an interrupted build under `root` (seed.txt), else draw a fresh one.
+        std::optional<std::uint64_t> masterSeed;
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        // Arrays generated and held in memory at once (for n <= streamAbove), fewer when
+        // they would exceed 2^24 ints in total.
+        int batchSize = 64;
+        // Arrays longer than this are never held in memory: each is generated chunk-wise by
+        // ArrayStream straight into arrays.csv. The cluster, stratified and combined samples
+        // take the same positions as in memory and pick their values up on the way; an
+        // order-preserving reservoir adds samples/sqrt n/reservoir sampling, and the
+        // value-stratified groups, which need the values first, are skipped. Streams follow
+        // the generators' value rules, not their exact random sequence, so such sets differ
+        // from in-memory ones of the same seed. INTERLEAVED_ARRAY has no stream and cannot be
+        // built above this size.
+        int streamAbove = 1 << 24;
+
+        // Sets are written as shards of shardSize arrays under <set>/shards/NNNNN, each closed
+        // by a _DONE marker; finished shards are skipped on a rerun. Once every shard of a set
+        // is done they are concatenated into the usual files and the set gets its own _DONE.
+        // Process w of shardWorkers only builds shards with index % shardWorkers == w.
+        int shardSize = 100;
+        int shardWorker = 0;
+        int shardWorkers = 1;
+
+        // Sort-benchmark shapes built by configure() after the runs sets:
+        // (workload ArrayType, its parameter), e.g. {ArrayType::NEARLY_SORTED_ARRAY, 100}.
+        std::vector<std::pair<ArrayType, int>> workloads;
+
+        // Each sample group gets samples.csv (the sampled values), or with indexOnlySamples
+        // samples.idx instead: delta-varint positions into arrays.csv, about 4x smaller, which
+        // also lets the Estimator tell clusters apart.
+        bool indexOnlySamples = false;
+
+        // Also write samples/pyramid/samples.pyr: nested samples of sizes S, 2S, 4S, ... < n.
+        bool writePyramid = false;
+
+        // Also write a "value stratified sampling" group per stratum group: position strata
+        // crossed with value quantile buckets (SamplingStrategy::VALUE_STRATIFIED).
+        bool valueStratified = false;
+
         std::vector<std::string> clusterGroups { "sqrt", "2sqrt", "log2", "2log2", "smlLength" };
 
         std::function<int(const std::string&, int /*S*/)> clusterSizer =
@@ -57,9 +116,9 @@ public:
     };
 
     ExperimentConfigurator(int n, int sampleSize, int minValue, int maxValue, const std::string& root)
-        : cfg_{n, sampleSize, minValue, maxValue, root} {}
+        : ExperimentConfigurator(Config{n, sampleSize, minValue, maxValue, root}) {}
 
-    explicit ExperimentConfigurator(Config cfg) : cfg_(std::move(cfg)) {}
+    explicit ExperimentConfigurator(Config cfg) : cfg_(std::move(cfg)), seed_(resolveSeed()) {}
 
     void configure(int countPerSet,
                    const std::vector<int>& kValues,
@@ -93,50 +152,136 @@ public:
             }
         }
 
-        std::cout << "[OK] experiment_data_input fully populated under: " << cfg_.root << "\n";
+        for (const auto& [type, param] : cfg_.workloads) {
+            std::cout << "[EXP] " << workloadLabel(type) << " n=" << cfg_.n
+                      << " p=" << param
+                      << " count=" << countPerSet << "\n";
+            generateWorkloadSet(type, param, countPerSet);
+        }
+
+        std::cout << "[OK] experiment_data_input fully populated (seed " << seed_ << ") under: " << cfg_.root << "\n";
     }
 
     void generatePermutationSet(int count) const {
-        DataGenerator gen;
-        std::vector<std::vector<int>> arrays;
-        arrays.reserve(count);
-        for (int i = 0; i < count; ++i) {
-            arrays.emplace_back(gen.generatePermutation(cfg_.n));
-        }
-        const std::string base = join(cfg_.root, join("permutation", toStr(cfg_.n)));
-        saveArraysAndAllSamples(arrays, base);
+        buildSet(setKey(ArrayType::PERMUTATION_ARRAY, 0), count, ArrayType::PERMUTATION_ARRAY, 0, 0);
     }
 
     void generateRandomSet(int k, int count) const {
-        DataGenerator gen;
-        std::vector<std::vector<int>> arrays; arrays.reserve(count);
-        for (int i = 0; i < count; ++i) {
-            arrays.emplace_back(gen.generateRandom(cfg_.n, cfg_.minValue, cfg_.maxValue, k));
-        }
-        const std::string base = join(cfg_.root,
-                                      join("random_array", join(toStr(cfg_.n), join("k", toStr(k)))));
-        saveArraysAndAllSamples(arrays, base);
+        buildSet(setKey(ArrayType::RANDOM_ARRAY, k), count, ArrayType::RANDOM_ARRAY, 0, k);
     }
 
     void generateRunsSet(int runs, int count) const {
-        DataGenerator gen;
-        std::vector<std::vector<int>> arrays;
-        arrays.reserve(count);
+        buildSet(setKey(ArrayType::RUNS_ARRAY, runs), count, ArrayType::RUNS_ARRAY, runs, 0);
+    }
 
-        int fails = 0;
-        while ((int)arrays.size() < count) {
-            try {
-                auto arr = gen.generateRuns(cfg_.n, runs, cfg_.minValue, cfg_.maxValue);
-                if ((int)arr.size() != cfg_.n) { ++fails; continue; }
-                arrays.emplace_back(std::move(arr));
-            } catch (...) { ++fails; continue; }
+    void generateWorkloadSet(ArrayType type, int param, int count) const {
+        buildSet(setKey(type, param), count, type, 0, param);
+    }
+
+    // Path of a set relative to the root. `param` is k for random arrays, the run count for
+    // runs arrays, the workload parameter otherwise (ignored for permutations and monotone
+    // arrays). Run counts that share a label (e.g. 100 and "sqrt n" at n=10000) share a set.
+    std::string setKey(ArrayType type, int param) const {
+        const std::string n = toStr(cfg_.n);
+        switch (type) {
+            case ArrayType::PERMUTATION_ARRAY: return join("permutation", n);
+            case ArrayType::SORTED_ARRAY:      return join("sorted", n);
+            case ArrayType::REVERSE_ARRAY:     return join("reverse", n);
+            case ArrayType::RANDOM_ARRAY:      return join("random_array", join(n, join("k", toStr(param))));
+            case ArrayType::RUNS_ARRAY:        return join("run_array", join(n, join("r", runsLabel(cfg_.n, param))));
+            default:                           return join(workloadLabel(type), join(n, join("p", toStr(param))));
         }
+    }
+
+    bool isComplete(const std::string& setKey) const {
+        return std::filesystem::exists(join(join(cfg_.root, setKey), DONE_MARKER));
+    }
+
+    int shardCount(int count) const {
+        const int size = std::max(1, cfg_.shardSize);
+        return (std::max(0, count) + size - 1) / size;
+    }
+
+    // Builds this worker's missing shards of a set, then merges the set if all shards are done.
+    void buildSet(const std::string& setKey, int count, ArrayType type, int runs, int k) const {
+        if (isComplete(setKey)) {
+            std::cout << "[SKIP] already complete: " << join(cfg_.root, setKey) << "\n";
+            return;
+        }
+        const int shards = shardCount(count);
+        for (int shard = 0; shard < shards; ++shard) {
+            if (shard % std::max(1, cfg_.shardWorkers) != cfg_.shardWorker) continue;
+            buildShard(setKey, count, shard, type, runs, k);
+        }
+        mergeSet(setKey, count);
+    }
+
+    // Writes shard `shard` of a set (arrays shard*shardSize ...) unless its marker exists.
+    // Shards are independent: any thread or process may build any of them.
+    void buildShard(const std::string& setKey, int count, int shard, ArrayType type, int runs, int k) const {
+        const std::string dir = shardDir(join(cfg_.root, setKey), shard);
+        if (std::filesystem::exists(join(dir, DONE_MARKER))) return;
+        std::filesystem::remove_all(dir); // leftovers of an interrupted attempt
+
+        const int size = std::max(1, cfg_.shardSize);
+        const int first = shard * size;
+        const int shardArrays = std::min(size, count - first);
+        // samples draw from substreams past the array indices of the set, two per shard
+        const std::uint64_t sampleStream = static_cast<std::uint64_t>(count) + 2ull * shard;
+        if (cfg_.n > cfg_.streamAbove) {
+            saveStreamedArrays(dir, setSeed(setKey), sampleStream, first, shardArrays, type, runs, k);
+            writeMarker(dir, shardArrays);
+            return;
+        }
+        saveArraysAndAllSamples(dir, setSeed(setKey), sampleStream, shardArrays,
+            [&](int offset, std::vector<std::vector<int>>& batch) {
+                fillArrays(setKey, first + offset, batch, [&](DataGenerator& gen, std::vector<int>& out) {
+                    gen.generate(type, out, cfg_.n, cfg_.minValue, cfg_.maxValue, runs, k);
+                });
+            });
+        writeMarker(dir, shardArrays);
+    }
+
+    // Merges the shards of a set into its files once all of them are done (see mergeShards).
+    void mergeSet(const std::string& setKey, int count) const {
+        mergeShards(join(cfg_.root, setKey), shardCount(count));
+    }
 
-        const std::string base = join(cfg_.root,
-            join("run_array", join(toStr(cfg_.n), join("r", runsLabel(cfg_.n, runs)))));
-        saveArraysAndAllSamples(arrays, base);
+    template <class Make>
+    std::vector<std::vector<int>> generateArrays(const std::string& setKey, int count, Make&& make) const {
+        std::vector<std::vector<int>> arrays(std::max(0, count));
+        fillArrays(setKey, 0, arrays, [&](DataGenerator& gen, std::vector<int>& out) { out = make(gen); });
+        return arrays;
     }
 
+    // fill(gen, batch[i]) regenerates array first+i of set `setKey`, drawn from substream
+    // first+i of the set's seed. Arrays are split across cfg_.threads workers.
+    template <class Fill>
+    void fillArrays(const std::string& setKey, int first, std::vector<std::vector<int>>& batch, Fill&& fill) const {
+        const std::uint64_t seed = setSeed(setKey);
+        const unsigned threads = std::max(1u, std::min(cfg_.threads, static_cast<unsigned>(batch.size())));
+
+        std::vector<std::exception_ptr> errors(threads);
+        auto worker = [&](unsigned t) {
+            try {
+                for (size_t i = t; i < batch.size(); i += threads) {
+                    DataGenerator gen(DataGenerator::substreamSeed(seed, first + i));
+                    gen.setThreads(cfg_.threads / threads); // leftover threads help within an array
+                    fill(gen, batch[i]);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto& th : pool) th.join();
+        for (auto& e : errors) if (e) std::rethrow_exception(e);
+    }
+
+    std::uint64_t getSeed() const { return seed_; }
+
     static std::vector<int> loadArrayByIndex(const std::string& csvPath, int index0) {
         std::ifstream f(csvPath);
         if (!f) throw std::runtime_error("Cannot open: " + csvPath);
@@ -152,10 +297,142 @@ public:
     }
 
 private:
+    static constexpr const char* DONE_MARKER = "_DONE";
+    static constexpr const char* MERGE_LOCK = ".merging";
+    static constexpr size_t STREAM_CHUNK = size_t(1) << 16;
+    static constexpr int BATCH_ELEMENTS = 1 << 24;
+
     Config cfg_;
+    std::uint64_t seed_;
+
+    std::uint64_t resolveSeed() const {
+        const std::string seedFile = join(cfg_.root, "seed.txt");
+        std::optional<std::uint64_t> stored;
+        if (!cfg_.root.empty()) {
+            std::ifstream in(seedFile);
+            std::uint64_t v;
+            if (in >> v) stored = v;
+        }
+        if (stored && cfg_.masterSeed && *stored != *cfg_.masterSeed) {
+            throw std::runtime_error("Root holds a build with seed " + std::to_string(*stored)
+                                     + "; resume with that seed or use another root");
+        }
+        const std::uint64_t seed = stored ? *stored
+                                 : cfg_.masterSeed ? *cfg_.masterSeed
+                                 : (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+        if (!stored && !cfg_.root.empty()) {
+            ensureDir(cfg_.root);
+            std::ofstream(seedFile) << seed << "\n";
+        }
+        return seed;
+    }
+
+    static std::string shardDir(const std::string& baseDir, int shard) {
+        std::string name = std::to_string(shard);
+        name.insert(0, name.size() < 5 ? 5 - name.size() : 0, '0');
+        return join(join(baseDir, "shards"), name);
+    }
+
+    // Concatenates every file of the shards, in shard order, into the set directory. Runs only
+    // when all shard markers exist, and only in the one worker that creates <set>/.merging;
+    // the others leave the set to it. Files are written under a per-worker temporary name and
+    // renamed into place, then the set marker is written and the shards are removed. A merge
+    // killed half-way leaves .merging behind: delete it to let the next run merge.
+    void mergeShards(const std::string& baseDir, int shards) const {
+        namespace fs = std::filesystem;
+        auto allShardsDone = [&] {
+            for (int shard = 0; shard < shards; ++shard) {
+                if (!fs::exists(join(shardDir(baseDir, shard), DONE_MARKER))) {
+                    std::cout << "[WAIT] shard " << shard << " of " << baseDir << " not finished\n";
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (!allShardsDone()) return;
+
+        const fs::path lock = fs::path(baseDir) / MERGE_LOCK;
+        if (!fs::create_directory(lock)) {
+            std::cout << "[WAIT] " << baseDir << " is being merged by another worker\n";
+            return;
+        }
+        // another worker may have merged (and removed the shards) since the check above
+        if (fs::exists(join(baseDir, DONE_MARKER)) || !allShardsDone()) {
+            fs::remove(lock);
+            return;
+        }
+
+        if (shards > 0) {
+            const fs::path first = shardDir(baseDir, 0);
+            for (const auto& entry : fs::recursive_directory_iterator(first)) {
+                if (!entry.is_regular_file() || entry.path().filename() == DONE_MARKER) continue;
+                const fs::path rel = fs::relative(entry.path(), first);
+                const fs::path target = fs::path(baseDir) / rel;
+                fs::create_directories(target.parent_path());
+                fs::path tmp = target;
+                tmp += ".part." + std::to_string(cfg_.shardWorker);
+                {
+                    std::ofstream out(tmp, std::ios::trunc | std::ios::binary);
+                    if (!out) throw std::runtime_error("Cannot open " + tmp.string());
+                    for (int shard = 0; shard < shards; ++shard) {
+                        std::ifstream in(fs::path(shardDir(baseDir, shard)) / rel, std::ios::binary);
+                        if (!in) throw std::runtime_error("Missing shard file " + rel.string());
+                        out << in.rdbuf();
+                    }
+                    checkWritten(out, tmp.string());
+                }
+                fs::rename(tmp, target);
+            }
+        }
+        writeMarker(baseDir, shards);
+        fs::remove_all(join(baseDir, "shards"));
+        fs::remove(lock);
+        std::cout << "[OK] arrays + samples saved under: " << baseDir << "\n";
+    }
+
+    // The one sample file of a group directory: samples.idx in index mode, else samples.csv.
+    std::string sampleFile(const std::string& dir) const {
+        return join(dir, cfg_.indexOnlySamples ? "samples.idx" : "samples.csv");
+    }
+
+    std::ofstream openSampleSink(const std::string& dir) const {
+        ensureDir(dir);
+        const std::string file = sampleFile(dir);
+        std::ofstream os(file, cfg_.indexOnlySamples ? std::ios::trunc | std::ios::binary : std::ios::trunc);
+        if (!os) throw std::runtime_error("Cannot open " + file);
+        return os;
+    }
+
+    void writeSampleRow(std::ofstream& os, const std::vector<int>& sample, const std::vector<int>& indices) const {
+        if (cfg_.indexOnlySamples) SampleCodec::writeRow(os, indices);
+        else writeRowCSV(os, sample);
+    }
+
+    // Flushes `os` and throws if any write to it failed, so no marker covers a short file.
+    static void checkWritten(std::ofstream& os, const std::string& what) {
+        os.flush();
+        if (!os.good()) throw std::runtime_error("Write failed: " + what);
+    }
+
+    static void writeMarker(const std::string& dir, int count) {
+        const std::string file = join(dir, DONE_MARKER);
+        std::ofstream marker(file, std::ios::trunc);
+        marker << count << "\n";
+        checkWritten(marker, file);
+    }
 
     static std::string toStr(int v) { return std::to_string(v); }
 
+    // Per-set seed: the master seed mixed with an FNV-1a hash of the set's relative path.
+    std::uint64_t setSeed(const std::string& setKey) const {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : setKey) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return DataGenerator::substreamSeed(seed_, h);
+    }
+
     static std::string join(const std::string& a, const std::string& b) {
         if (a.empty()) return b;
         const char sep = '/';
@@ -187,6 +464,18 @@ private:
         return "r_" + std::to_string(runs);
     }
 
+    static std::string workloadLabel(ArrayType type) {
+        switch (type) {
+            case ArrayType::NEARLY_SORTED_ARRAY: return "nearly_sorted";
+            case ArrayType::SORTED_TAIL_ARRAY:   return "sorted_tail";
+            case ArrayType::SAWTOOTH_ARRAY:      return "sawtooth";
+            case ArrayType::ORGAN_PIPE_ARRAY:    return "organ_pipe";
+            case ArrayType::ZIPF_ARRAY:          return "zipf";
+            case ArrayType::INTERLEAVED_ARRAY:   return "interleaved";
+            default:                             throw std::invalid_argument("Not a workload ArrayType");
+        }
+    }
+
     static std::string clusterFolderLabel(const std::string& key) {
         if (key == "sqrt")      return "sqrt smlLength";
         if (key == "2sqrt")     return "2sqrt smlLength";
@@ -200,75 +489,190 @@ private:
         return key;
     }
 
-    void saveArraysAndAllSamples(const std::vector<std::vector<int>>& arrays,
-                                 const std::string& baseDir) const
+    // The cluster, stratified and combined groups, which depend only on positions, with the
+    // directories their samples go to under samplesRoot.
+    void positionalGroups(const std::string& samplesRoot, std::vector<MultiSampler::Group>& groups,
+                          std::vector<std::string>& dirs) const
     {
-        // 1) arrays.csv
-        const std::string arraysCsv = join(baseDir, "arrays.csv");
-        ensureDir(std::filesystem::path(arraysCsv).parent_path().string());
-        {
-            std::ofstream ofs(arraysCsv, std::ios::trunc);
-            if (!ofs) throw std::runtime_error("Cannot open " + arraysCsv);
-            for (const auto& v : arrays) writeRowCSV(ofs, v);
-        }
-
-        const std::string samplesRoot = join(join(baseDir, "samples"), "sqrt n");
-
         // Cluster sampling
         for (const auto& cg : cfg_.clusterGroups) {
             const int clSize = cfg_.clusterSizer(cg, cfg_.sampleSize);
-            const std::string dir = join(join(samplesRoot, "cluster sampling"),
-                                         clusterFolderLabel(cg));
-            ensureDir(dir);
-            const std::string csv = join(dir, "samples.csv");
-            std::ofstream ofs(csv, std::ios::trunc);
-            if (!ofs) throw std::runtime_error("Cannot open " + csv);
-
-            for (const auto& baseArr : arrays) {
-                Sampler sam(baseArr, cfg_.sampleSize);
-                sam.setStrategy(SamplingStrategy::CLUSTER);
-                sam.createSample(/*clusterSize*/ clSize, /*stratSize*/ 0);
-                writeRowCSV(ofs, sam.getSample());
-            }
+            groups.push_back({SamplingStrategy::CLUSTER, /*clusterSize*/ clSize, /*stratSize*/ 0});
+            dirs.push_back(join(join(samplesRoot, "cluster sampling"), clusterFolderLabel(cg)));
         }
 
         // Stratified sampling
         for (const auto& sg : cfg_.stratumGroups) {
             const int strSize = cfg_.stratumSizer(sg, cfg_.n, cfg_.sampleSize);
-            const std::string dir = join(join(samplesRoot, "stratified sampling"),
-                                         stratumFolderLabel(sg));
-            ensureDir(dir);
-            const std::string csv = join(dir, "samples.csv");
-            std::ofstream ofs(csv, std::ios::trunc);
-            if (!ofs) throw std::runtime_error("Cannot open " + csv);
-
-            for (const auto& baseArr : arrays) {
-                Sampler sam(baseArr, cfg_.sampleSize);
-                sam.setStrategy(SamplingStrategy::STRATIFIED);
-                sam.createSample(/*clusterSize*/ 0, /*stratSize*/ strSize);
-                writeRowCSV(ofs, sam.getSample());
-            }
+            groups.push_back({SamplingStrategy::STRATIFIED, /*clusterSize*/ 0, /*stratSize*/ strSize});
+            dirs.push_back(join(join(samplesRoot, "stratified sampling"), stratumFolderLabel(sg)));
         }
 
         // Combined sampling
         for (const auto& sg : cfg_.stratumGroups) {
             const int strSize = cfg_.stratumSizer(sg, cfg_.n, cfg_.sampleSize);
-            const std::string dir = join(join(samplesRoot, "combined sampling"),
-                                         stratumFolderLabel(sg));
+            groups.push_back({SamplingStrategy::COMBINED, /*clusterSize*/ 0, /*stratSize*/ strSize});
+            dirs.push_back(join(join(samplesRoot, "combined sampling"), stratumFolderLabel(sg)));
+        }
+    }
+
+    // Arrays first .. first+count-1 of a set with n > streamAbove: array i comes from substream
+    // i of `seed` (as in fillArrays) and goes to arrays.csv in STREAM_CHUNK pieces. Its
+    // reservoir sample is drawn from substream i of substream sampleStream. The positional
+    // groups draw their positions up front from substream sampleStream, exactly as the
+    // in-memory path does, and pick the values up as the chunks stream past.
+    void saveStreamedArrays(const std::string& baseDir, std::uint64_t seed, std::uint64_t sampleStream,
+                            int first, int count, ArrayType type, int runs, int k) const
+    {
+        const std::string arraysCsv = join(baseDir, "arrays.csv");
+        ensureDir(baseDir);
+        std::ofstream arraysOfs(arraysCsv, std::ios::trunc);
+        if (!arraysOfs) throw std::runtime_error("Cannot open " + arraysCsv);
+
+        const std::string samplesRoot = join(join(baseDir, "samples"), "sqrt n");
+        const std::string reservoirDir = join(samplesRoot, "reservoir sampling");
+        std::ofstream reservoirOfs = openSampleSink(reservoirDir);
+
+        std::vector<MultiSampler::Group> groups;
+        std::vector<std::string> dirs;
+        positionalGroups(samplesRoot, groups, dirs);
+        std::vector<std::ofstream> sinks;
+        for (const auto& d : dirs) sinks.push_back(openSampleSink(d));
+        MultiSampler multi(std::move(groups), cfg_.sampleSize,
+                           static_cast<std::uint32_t>(DataGenerator::substreamSeed(seed, sampleStream)));
+
+        std::ofstream pyramidOfs;
+        std::mt19937 pyramidGen(static_cast<std::uint32_t>(DataGenerator::substreamSeed(seed, sampleStream + 1)));
+        if (cfg_.writePyramid) {
+            const std::string pyrDir = join(join(baseDir, "samples"), "pyramid");
+            ensureDir(pyrDir);
+            pyramidOfs.open(join(pyrDir, "samples.pyr"), std::ios::trunc | std::ios::binary);
+            if (!pyramidOfs) throw std::runtime_error("Cannot open samples.pyr in " + pyrDir);
+        }
+
+        const size_t G = sinks.size();
+        // per group: the drawn positions (in sample order), the sample slots by increasing
+        // position, the values picked so far and how many slots are filled
+        std::vector<std::vector<int>> positions(G), order(G), picked(G);
+        std::vector<size_t> filled(G);
+        const std::uint64_t sampleSeed = DataGenerator::substreamSeed(seed, sampleStream);
+        std::vector<int> indices, values;
+        for (int i = 0; i < count; ++i) {
+            multi.positionsAll(cfg_.n, [&](size_t g, const std::vector<int>& idx) {
+                positions[g] = idx;
+                order[g].resize(idx.size());
+                std::iota(order[g].begin(), order[g].end(), 0);
+                std::sort(order[g].begin(), order[g].end(), [&](int a, int b) { return idx[a] < idx[b]; });
+                picked[g].assign(idx.size(), 0);
+                filled[g] = 0;
+            });
+
+            auto stream = ArrayStream::make(type, static_cast<size_t>(cfg_.n), cfg_.minValue, cfg_.maxValue,
+                                            runs, k, DataGenerator::substreamSeed(seed, first + i));
+            ReservoirSampler reservoir(cfg_.sampleSize,
+                                       static_cast<std::uint32_t>(DataGenerator::substreamSeed(sampleSeed, i)));
+            CsvRowSink row(arraysOfs);
+            size_t offset = 0;
+            stream->drain(STREAM_CHUNK, [&](std::span<const int> chunk) {
+                row(chunk);
+                reservoir.pushRange(chunk.begin(), chunk.end());
+                const size_t end = offset + chunk.size();
+                for (size_t g = 0; g < G; ++g) {
+                    for (; filled[g] < order[g].size(); ++filled[g]) {
+                        const int slot = order[g][filled[g]];
+                        const size_t pos = static_cast<size_t>(positions[g][slot]);
+                        if (pos >= end) break;
+                        picked[g][slot] = chunk[pos - offset];
+                    }
+                }
+                offset = end;
+            });
+            row.endRow();
+
+            indices.clear();
+            values.clear();
+            for (const auto& e : reservoir.entries()) {
+                indices.push_back(static_cast<int>(e.index));
+                values.push_back(e.value);
+            }
+            writeSampleRow(reservoirOfs, values, indices);
+            for (size_t g = 0; g < G; ++g) writeSampleRow(sinks[g], picked[g], positions[g]);
+            if (cfg_.writePyramid) {
+                SamplePyramid::write(pyramidOfs, SamplePyramid::build(cfg_.n, cfg_.sampleSize, pyramidGen));
+            }
+        }
+
+        checkWritten(arraysOfs, arraysCsv);
+        checkWritten(reservoirOfs, sampleFile(reservoirDir));
+        for (size_t g = 0; g < G; ++g) checkWritten(sinks[g], sampleFile(dirs[g]));
+        if (cfg_.writePyramid) checkWritten(pyramidOfs, "samples.pyr in " + baseDir);
+    }
+
+    // nextBatch(first, batch) overwrites batch[i] with array first+i of the shard. Samples come
+    // from substream sampleStream of `seed`, the pyramid from sampleStream + 1.
+    template <class NextBatch>
+    void saveArraysAndAllSamples(const std::string& baseDir,
+                                 std::uint64_t seed,
+                                 std::uint64_t sampleStream,
+                                 int count,
+                                 NextBatch&& nextBatch) const
+    {
+        // 1) arrays.csv
+        const std::string arraysCsv = join(baseDir, "arrays.csv");
+        ensureDir(std::filesystem::path(arraysCsv).parent_path().string());
+        std::ofstream arraysOfs(arraysCsv, std::ios::trunc);
+        if (!arraysOfs) throw std::runtime_error("Cannot open " + arraysCsv);
+
+        const std::string samplesRoot = join(join(baseDir, "samples"), "sqrt n");
+
+        // 2) samples.csv (or samples.idx) per group, all filled in a single pass over the arrays
+        std::vector<MultiSampler::Group> groups;
+        std::vector<std::string> dirs;
+        positionalGroups(samplesRoot, groups, dirs);
+
+        // Value-stratified sampling
+        for (const auto& sg : cfg_.valueStratified ? cfg_.stratumGroups : std::vector<std::string>{}) {
+            const int strSize = cfg_.stratumSizer(sg, cfg_.n, cfg_.sampleSize);
+            groups.push_back({SamplingStrategy::VALUE_STRATIFIED, /*clusterSize*/ 0, /*stratSize*/ strSize});
+            dirs.push_back(join(join(samplesRoot, "value stratified sampling"), stratumFolderLabel(sg)));
+        }
+        std::vector<std::ofstream> sinks;
+        for (const auto& d : dirs) sinks.push_back(openSampleSink(d));
+
+        std::ofstream pyramidOfs;
+        std::mt19937 pyramidGen(static_cast<std::uint32_t>(DataGenerator::substreamSeed(seed, sampleStream + 1)));
+        if (cfg_.writePyramid) {
+            const std::string dir = join(join(baseDir, "samples"), "pyramid");
             ensureDir(dir);
-            const std::string csv = join(dir, "samples.csv");
-            std::ofstream ofs(csv, std::ios::trunc);
-            if (!ofs) throw std::runtime_error("Cannot open " + csv);
-
-            for (const auto& baseArr : arrays) {
-                Sampler sam(baseArr, cfg_.sampleSize);
-                sam.setStrategy(SamplingStrategy::COMBINED);
-                sam.createSample(/*clusterSize*/ 0, /*stratSize*/ strSize);
-                writeRowCSV(ofs, sam.getSample());
+            const std::string file = join(dir, "samples.pyr");
+            pyramidOfs.open(file, std::ios::trunc | std::ios::binary);
+            if (!pyramidOfs) throw std::runtime_error("Cannot open " + file);
+        }
+
+        // 3) each array is visited once, batch by batch: written to arrays.csv and sampled for every group
+        MultiSampler multi(std::move(groups), cfg_.sampleSize,
+                           static_cast<std::uint32_t>(DataGenerator::substreamSeed(seed, sampleStream)));
+        const int batchSize = std::max(1, std::min(cfg_.batchSize, BATCH_ELEMENTS / std::max(1, cfg_.n)));
+        std::vector<std::vector<int>> batch;
+        for (int first = 0; first < count; first += batchSize) {
+            batch.resize(std::min(batchSize, count - first));
+            nextBatch(first, batch);
+            for (const auto& baseArr : batch) {
+                writeRowCSV(arraysOfs, baseArr);
+                if (cfg_.writePyramid) {
+                    SamplePyramid::write(pyramidOfs,
+                        SamplePyramid::build((int)baseArr.size(), cfg_.sampleSize, pyramidGen));
+                }
+                multi.sampleAll(baseArr, [&](size_t g, const std::vector<int>& sample,
+                                             const std::vector<int>& indices) {
+                    writeSampleRow(sinks[g], sample, indices);
+                });
             }
         }
 
-        std::cout << "[OK] arrays + samples saved under: " << baseDir << "\n";
+        checkWritten(arraysOfs, arraysCsv);
+        for (size_t g = 0; g < sinks.size(); ++g) checkWritten(sinks[g], sampleFile(dirs[g]));
+        if (cfg_.writePyramid) checkWritten(pyramidOfs, "samples.pyr in " + baseDir);
     }
 };
 
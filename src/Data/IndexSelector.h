@@ -0,0 +1,147 @@
+
+
+#ifndef INDEXSELECTOR_H
+#define INDEXSELECTOR_H
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+// Sequential random sampling (Vitter, "An Efficient Algorithm for Sequential
+// Random Sampling", 1987). Selects `take` distinct indices from [begin, end)
+// uniformly at random and emits them in increasing order: no hashing, no sort,
+// O(take) expected time (Algorithm D) with Algorithm A for the dense tail.
+class IndexSelector {
+public:
+
+    template <class Emit>
+    static void selectSorted(int begin, int end, int take, std::mt19937& gen, Emit&& emit) {
+        const int N = end - begin;
+        if (take <= 0 || N <= 0) return;
+        if (take >= N) {
+            for (int i = begin; i < end; ++i) emit(i);
+            return;
+        }
+        algorithmD(begin, N, take, gen, emit);
+    }
+
+private:
+
+    // Switch from D to A once take >= N / ALPHA_INV (Vitter's recommended 13).
+    static constexpr int ALPHA_INV = 13;
+
+    // Uniform in the open interval (0, 1); log() of it must stay finite.
+    static double uniform(std::mt19937& gen) {
+        double u;
+        do {
+            u = std::generate_canonical<double, 53>(gen);
+        } while (u <= 0.0);
+        return u;
+    }
+
+    template <class Emit>
+    static void algorithmD(int current, int N, int n, std::mt19937& gen, Emit& emit) {
+        double nreal = n;
+        double ninv = 1.0 / nreal;
+        double Nreal = N;
+        double Vprime = std::exp(std::log(uniform(gen)) * ninv);
+        int qu1 = N - n + 1;
+        double qu1real = Nreal - nreal + 1.0;
+        long long threshold = static_cast<long long>(ALPHA_INV) * n;
+
+        while (n > 1 && threshold < N) {
+            const double nmin1inv = 1.0 / (nreal - 1.0);
+            int S;
+            while (true) {
+                // D2: draw the skip candidate S from the continuous envelope
+                double X;
+                while (true) {
+                    X = Nreal * (1.0 - Vprime);
+                    S = static_cast<int>(X);
+                    if (S < qu1) break;
+                    Vprime = std::exp(std::log(uniform(gen)) * ninv);
+                }
+
+                const double U = uniform(gen);
+                const double negSreal = -static_cast<double>(S);
+
+                // D3: cheap squeeze test
+                const double y1 = std::exp(std::log(U * Nreal / qu1real) * nmin1inv);
+                Vprime = y1 * (1.0 - X / Nreal) * (qu1real / (negSreal + qu1real));
+                if (Vprime <= 1.0) break;
+
+                // D4: exact acceptance test
+                double y2 = 1.0;
+                double top = Nreal - 1.0;
+                double bottom;
+                int limit;
+                if (n - 1 > S) {
+                    bottom = Nreal - nreal;
+                    limit = N - S;
+                } else {
+                    bottom = Nreal + negSreal - 1.0;
+                    limit = qu1;
+                }
+                for (int t = N - 1; t >= limit; --t) {
+                    y2 = (y2 * top) / bottom;
+                    top -= 1.0;
+                    bottom -= 1.0;
+                }
+                if (Nreal / (Nreal - X) >= y1 * std::exp(std::log(y2) * nmin1inv)) {
+                    Vprime = std::exp(std::log(uniform(gen)) * nmin1inv);
+                    break;
+                }
+                Vprime = std::exp(std::log(uniform(gen)) * ninv);
+            }
+
+            current += S;
+            emit(current);
+            ++current;
+
+            N = N - S - 1;
+            Nreal = Nreal - S - 1.0;
+            --n;
+            nreal -= 1.0;
+            ninv = nmin1inv;
+            qu1 -= S;
+            qu1real -= S;
+            threshold -= ALPHA_INV;
+        }
+
+        if (n > 1) {
+            algorithmA(current, N, n, gen, emit);
+        } else {
+            const int S = std::min(N - 1, static_cast<int>(N * Vprime));
+            emit(current + S);
+        }
+    }
+
+    template <class Emit>
+    static void algorithmA(int current, int N, int n, std::mt19937& gen, Emit& emit) {
+        double top = N - n;
+        double Nreal = N;
+
+        while (n >= 2) {
+            const double V = uniform(gen);
+            int S = 0;
+            double quot = top / Nreal;
+            while (quot > V) {
+                ++S;
+                top -= 1.0;
+                Nreal -= 1.0;
+                quot = (quot * top) / Nreal;
+            }
+            current += S;
+            emit(current);
+            ++current;
+            Nreal -= 1.0;
+            --n;
+        }
+
+        const int remaining = static_cast<int>(std::lround(Nreal));
+        const int S = std::min(remaining - 1, static_cast<int>(remaining * uniform(gen)));
+        emit(current + S);
+    }
+};
+
+#endif //INDEXSELECTOR_H
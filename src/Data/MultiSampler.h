@@ -0,0 +1,62 @@
+
+
+#ifndef MULTISAMPLER_H
+#define MULTISAMPLER_H
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Sampler.h"
+#include "SamplingStrategy.h"
+
+
+// Produces the samples of every configured group from one array in a single visit.
+// All groups share one random stream and the array stays cache-resident between them,
+// instead of re-reading the whole array set once per group.
+class MultiSampler {
+
+public:
+    struct Group {
+        SamplingStrategy strategy;
+        int clusterSize;
+        int stratSize;
+    };
+
+    MultiSampler(std::vector<Group> groups, int sampleLength)
+        : MultiSampler(std::move(groups), sampleLength, std::random_device{}()) {}
+
+    MultiSampler(std::vector<Group> groups, int sampleLength, std::uint32_t seed)
+        : groups(std::move(groups)), sampler({}, sampleLength), gen(seed) {}
+
+    // sink(groupIndex, sample, sampleIndices) is called once per group, in group order.
+    template <class Sink>
+    void sampleAll(const std::vector<int>& array, Sink&& sink) {
+        sampler.setArray(array);
+        for (size_t g = 0; g < groups.size(); ++g) {
+            sampler.setStrategy(groups[g].strategy);
+            sampler.createSample(groups[g].clusterSize, groups[g].stratSize, gen);
+            sink(g, sampler.getSample(), sampler.getSampleIndices());
+        }
+    }
+
+    // Same draws without the array's values, for an array of length n that is not in memory:
+    // sink(groupIndex, sampleIndices), positional strategies only (Sampler::createPositions).
+    template <class Sink>
+    void positionsAll(int n, Sink&& sink) {
+        for (size_t g = 0; g < groups.size(); ++g) {
+            sampler.setStrategy(groups[g].strategy);
+            sampler.createPositions(n, groups[g].clusterSize, groups[g].stratSize, gen);
+            sink(g, sampler.getSampleIndices());
+        }
+    }
+
+    const std::vector<Group>& getGroups() const { return groups; }
+
+private:
+    std::vector<Group> groups;
+    Sampler sampler;
+    std::mt19937 gen;
+};
+
+#endif //MULTISAMPLER_H
@@ -0,0 +1,113 @@
+
+
+#ifndef PARALLELSHUFFLE_H
+#define PARALLELSHUFFLE_H
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "DataGenerator.h"
+
+
+// Uniform shuffle for arrays far larger than the cache, reproducible from a seed whatever the
+// thread count. Scatter shuffle: every element gets an independent uniform bucket label, the
+// buckets are concatenated in label order and each bucket is shuffled on its own. Labels come
+// from one random substream per fixed input block, bucket shuffles from one per bucket, so
+// the work splits across threads without changing the result. Buckets are sized to stay
+// cache-resident while they are shuffled; costs one scratch copy of the array.
+class ParallelShuffle {
+public:
+    static constexpr size_t MIN_PARALLEL = size_t(1) << 18;
+
+    static void shuffle(std::span<int> data, std::uint64_t seed, unsigned threads) {
+        const size_t n = data.size();
+        if (n < MIN_PARALLEL) {
+            std::mt19937_64 gen(seed);
+            std::shuffle(data.begin(), data.end(), gen);
+            return;
+        }
+        threads = std::max(1u, threads);
+
+        const size_t buckets = std::min(MAX_BUCKETS, (n + BUCKET_TARGET - 1) / BUCKET_TARGET);
+        const size_t blocks = std::min(MAX_BLOCKS, (n + MIN_BLOCK - 1) / MIN_BLOCK);
+
+        // labels of block b are replayed from its substream in both passes instead of stored
+        auto forEachLabel = [&](size_t b, auto&& visit) {
+            std::mt19937 gen(static_cast<std::uint32_t>(DataGenerator::substreamSeed(seed, b)));
+            const size_t end = (b + 1) * n / blocks;
+            for (size_t i = b * n / blocks; i < end; ++i) visit(i, label(gen, buckets));
+        };
+
+        // 1) per-block bucket counts
+        std::vector<size_t> cursor(blocks * buckets, 0);
+        parallelFor(blocks, threads, [&](size_t b) {
+            size_t* count = &cursor[b * buckets];
+            forEachLabel(b, [&](size_t, size_t k) { ++count[k]; });
+        });
+
+        // 2) write cursors: bucket-major, block order within a bucket
+        std::vector<size_t> bucketStart(buckets + 1, 0);
+        size_t total = 0;
+        for (size_t k = 0; k < buckets; ++k) {
+            bucketStart[k] = total;
+            for (size_t b = 0; b < blocks; ++b) {
+                const size_t c = cursor[b * buckets + k];
+                cursor[b * buckets + k] = total;
+                total += c;
+            }
+        }
+        bucketStart[buckets] = n;
+
+        // 3) scatter, then shuffle each bucket and copy it back in place
+        std::vector<int> scratch(n);
+        parallelFor(blocks, threads, [&](size_t b) {
+            size_t* next = &cursor[b * buckets];
+            forEachLabel(b, [&](size_t i, size_t k) { scratch[next[k]++] = data[i]; });
+        });
+        parallelFor(buckets, threads, [&](size_t k) {
+            std::mt19937_64 gen(DataGenerator::substreamSeed(seed, blocks + k));
+            const auto first = scratch.begin() + bucketStart[k];
+            const auto last = scratch.begin() + bucketStart[k + 1];
+            std::shuffle(first, last, gen);
+            std::copy(first, last, data.begin() + bucketStart[k]);
+        });
+    }
+
+private:
+    static constexpr size_t BUCKET_TARGET = size_t(1) << 16; // ints per bucket (256 KiB)
+    static constexpr size_t MAX_BUCKETS = 4096;
+    static constexpr size_t MIN_BLOCK = size_t(1) << 16;
+    static constexpr size_t MAX_BLOCKS = 256;
+
+    // Unbiased draw from [0, range) with one multiply in the common case (Lemire).
+    static size_t label(std::mt19937& gen, size_t range) {
+        const std::uint32_t r = static_cast<std::uint32_t>(range);
+        std::uint64_t m = static_cast<std::uint64_t>(gen()) * r;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < r) {
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-r) % r;
+            while (low < threshold) {
+                m = static_cast<std::uint64_t>(gen()) * r;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<size_t>(m >> 32);
+    }
+
+    template <class Body>
+    static void parallelFor(size_t count, unsigned threads, Body&& body) {
+        const unsigned workers = static_cast<unsigned>(std::min<size_t>(threads, count));
+        auto worker = [&](unsigned t) {
+            for (size_t i = t; i < count; i += workers) body(i);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < workers; ++t) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto& th : pool) th.join();
+    }
+};
+
+#endif //PARALLELSHUFFLE_H
@@ -0,0 +1,112 @@
+
+
+#ifndef RESERVOIRSAMPLER_H
+#define RESERVOIRSAMPLER_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+// Fixed-size uniform sample of a stream of unknown length (Li's Algorithm L).
+// Elements between replacements are skipped in geometric jumps, so the random
+// stream is touched O(k (1 + log(N/k))) times. The sample is emitted in original
+// stream order, which keeps disorder metrics on it meaningful.
+class ReservoirSampler {
+
+public:
+    struct Entry {
+        long long index;
+        int value;
+    };
+
+    explicit ReservoirSampler(int capacity)
+        : ReservoirSampler(capacity, std::random_device{}()) {}
+
+    ReservoirSampler(int capacity, std::uint32_t seed)
+        : capacity(std::max(0, capacity)), gen(seed) {
+        reservoir.reserve(this->capacity);
+    }
+
+    void push(int value) {
+        const long long index = seen++;
+        if ((long long)reservoir.size() < capacity) {
+            reservoir.push_back({index, value});
+            if ((long long)reservoir.size() == capacity) {
+                W = std::exp(std::log(uniform()) / capacity);
+                scheduleNext(index);
+            }
+            return;
+        }
+        if (index == next) {
+            std::uniform_int_distribution<int> slot(0, capacity - 1);
+            reservoir[slot(gen)] = {index, value};
+            W *= std::exp(std::log(uniform()) / capacity);
+            scheduleNext(index);
+        }
+    }
+
+    // Feeds a whole range; skipped elements are jumped over without being read.
+    template <class It>
+    void pushRange(It first, It last) {
+        while (first != last) {
+            if ((long long)reservoir.size() == capacity && next > seen) {
+                const long long gap = next - seen;
+                const long long left = static_cast<long long>(std::distance(first, last));
+                if (gap >= left) {
+                    seen += left;
+                    return;
+                }
+                std::advance(first, gap);
+                seen += gap;
+            }
+            push(*first);
+            ++first;
+        }
+    }
+
+    // Sample entries ordered by their position in the stream.
+    std::vector<Entry> entries() const {
+        std::vector<Entry> out = reservoir;
+        std::sort(out.begin(), out.end(),
+            [](const Entry& a, const Entry& b) { return a.index < b.index; });
+        return out;
+    }
+
+    std::vector<int> sample() const {
+        std::vector<int> out;
+        out.reserve(reservoir.size());
+        for (const auto& e : entries()) out.push_back(e.value);
+        return out;
+    }
+
+    long long getSeen() const { return seen; }
+    int getCapacity() const { return capacity; }
+
+private:
+    int capacity;
+    std::mt19937 gen;
+    std::vector<Entry> reservoir;
+    long long seen = 0;
+    long long next = std::numeric_limits<long long>::max();
+    double W = 1.0;
+
+    double uniform() {
+        double u;
+        do {
+            u = std::generate_canonical<double, 53>(gen);
+        } while (u <= 0.0);
+        return u;
+    }
+
+    void scheduleNext(long long index) {
+        const double skip = std::floor(std::log(uniform()) / std::log1p(-W));
+        next = (skip >= (double)std::numeric_limits<long long>::max() - index - 1)
+                   ? std::numeric_limits<long long>::max()
+                   : index + static_cast<long long>(skip) + 1;
+    }
+};
+
+#endif //RESERVOIRSAMPLER_H
@@ -0,0 +1,89 @@
+
+
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+
+// Index-only sample rows (samples.idx): one row per sample, holding the positions
+// of its elements in the matching arrays.csv row instead of copies of the values.
+//
+// Row layout: varint(count), then count zigzag-varint deltas (first delta is from -1).
+// Sorted samples give small positive deltas (1 byte each for dense strata); zigzag
+// keeps rows whose order is not monotone (cluster gap filling) lossless.
+class SampleCodec {
+public:
+
+    static void writeRow(std::ostream& os, const std::vector<int>& indices) {
+        writeVarint(os, indices.size());
+        long long prev = -1;
+        for (int idx : indices) {
+            writeVarint(os, zigzag(static_cast<long long>(idx) - prev));
+            prev = idx;
+        }
+    }
+
+    // Returns false at a clean end of stream.
+    static bool readRow(std::istream& is, std::vector<int>& indices) {
+        indices.clear();
+        std::uint64_t count;
+        if (!readVarint(is, count)) return false;
+        indices.reserve(count);
+        long long prev = -1;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::uint64_t raw;
+            if (!readVarint(is, raw)) throw std::runtime_error("Truncated index row");
+            prev += unzigzag(raw);
+            indices.push_back(static_cast<int>(prev));
+        }
+        return true;
+    }
+
+    static std::vector<int> gather(const std::vector<int>& base, const std::vector<int>& indices) {
+        std::vector<int> out;
+        out.reserve(indices.size());
+        for (int idx : indices) {
+            if (idx < 0 || idx >= (int)base.size()) throw std::out_of_range("Sample index outside base array");
+            out.push_back(base[idx]);
+        }
+        return out;
+    }
+
+private:
+
+    static std::uint64_t zigzag(long long v) {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    static long long unzigzag(std::uint64_t v) {
+        return static_cast<long long>(v >> 1) ^ -static_cast<long long>(v & 1);
+    }
+
+    static void writeVarint(std::ostream& os, std::uint64_t v) {
+        while (v >= 0x80) {
+            os.put(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        os.put(static_cast<char>(v));
+    }
+
+    static bool readVarint(std::istream& is, std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const int c = is.get();
+            if (c == std::char_traits<char>::eof()) {
+                if (shift == 0) return false;
+                throw std::runtime_error("Truncated varint");
+            }
+            v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+};
+
+#endif //SAMPLECODEC_H
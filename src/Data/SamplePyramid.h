@@ -0,0 +1,102 @@
+
+
+#ifndef SAMPLEPYRAMID_H
+#define SAMPLEPYRAMID_H
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "IndexSelector.h"
+#include "SampleCodec.h"
+
+
+// Nested uniform samples of one array at sizes S, 2S, 4S, ... (< n; the full array is the
+// implied top level). Each level is a superset of the one below: level k adds a uniform
+// draw from the positions not yet taken, so every level is itself a simple random sample.
+//
+// Only the increments are stored (samples.pyr), each as a SampleCodec row of sorted
+// positions; per array a header row lists the cumulative level sizes.
+class SamplePyramid {
+public:
+
+    static std::vector<int> levelSizes(int n, int baseSize) {
+        std::vector<int> sizes;
+        if (n <= 0 || baseSize <= 0) return sizes;
+        for (long long s = baseSize; s < n; s *= 2) sizes.push_back(static_cast<int>(s));
+        return sizes;
+    }
+
+    // increments[k] holds the sorted positions added at level k.
+    static std::vector<std::vector<int>> build(int n, int baseSize, std::mt19937& gen) {
+        const std::vector<int> sizes = levelSizes(n, baseSize);
+        std::vector<std::vector<int>> increments;
+        increments.reserve(sizes.size());
+
+        std::vector<int> taken;
+        int have = 0;
+        for (int target : sizes) {
+            const int add = target - have;
+            std::vector<int> fresh;
+            fresh.reserve(add);
+
+            // ordinals over the complement of `taken`, mapped back to positions in one scan
+            size_t t = 0;
+            int skipped = 0;
+            IndexSelector::selectSorted(0, n - have, add, gen, [&](int ord) {
+                int posAt = ord + skipped;
+                while (t < taken.size() && taken[t] <= posAt) {
+                    ++t;
+                    ++skipped;
+                    ++posAt;
+                }
+                fresh.push_back(posAt);
+            });
+
+            const size_t mid = taken.size();
+            taken.insert(taken.end(), fresh.begin(), fresh.end());
+            std::inplace_merge(taken.begin(), taken.begin() + mid, taken.end());
+            increments.push_back(std::move(fresh));
+            have = target;
+        }
+        return increments;
+    }
+
+    static void write(std::ostream& os, const std::vector<std::vector<int>>& increments) {
+        std::vector<int> cumulative;
+        int total = 0;
+        for (const auto& inc : increments) {
+            total += static_cast<int>(inc.size());
+            cumulative.push_back(total);
+        }
+        SampleCodec::writeRow(os, cumulative);
+        for (const auto& inc : increments) SampleCodec::writeRow(os, inc);
+    }
+
+    // Returns false at a clean end of stream.
+    static bool read(std::istream& is, std::vector<std::vector<int>>& increments) {
+        increments.clear();
+        std::vector<int> cumulative;
+        if (!SampleCodec::readRow(is, cumulative)) return false;
+        increments.resize(cumulative.size());
+        for (auto& inc : increments) {
+            if (!SampleCodec::readRow(is, inc)) throw std::runtime_error("Truncated pyramid");
+        }
+        return true;
+    }
+
+    // Sorted positions of `level`: the merge of increments 0..level.
+    static std::vector<int> level(const std::vector<std::vector<int>>& increments, size_t level) {
+        std::vector<int> out;
+        for (size_t k = 0; k <= level && k < increments.size(); ++k) {
+            const size_t mid = out.size();
+            out.insert(out.end(), increments[k].begin(), increments[k].end());
+            std::inplace_merge(out.begin(), out.begin() + mid, out.end());
+        }
+        return out;
+    }
+};
+
+#endif //SAMPLEPYRAMID_H
@@ -6,9 +6,14 @@
 #include <stdlib.h>
 #include <vector>
 
+#include "IndexSelector.h"
+#include "ReservoirSampler.h"
 #include "SamplingStrategy.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <random>
-#include <unordered_set>
+#include <stdexcept>
 
 
 class Sampler {
@@ -18,27 +23,44 @@ private:
     int sampleLength;
     SamplingStrategy strategy;
     std::vector<int> sample;
-
+    std::vector<int> sampleIdx; // positions in arr of each sample element, same order
+    int valueStrata = 4;        // value quantile buckets for VALUE_STRATIFIED
+    int positionsOf = -1;       // createPositions: length of an array whose values are absent
 
 public:
     Sampler(const std::vector<int> inputArray, int sampleLength)
         : arr(inputArray), sampleLength(sampleLength) {}
 
     void createSample(int clusterSize, int stratSize) {
-        sample.clear();
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        createSample(clusterSize, stratSize, gen);
+    }
+
+    // Same as above, but draws from a caller-owned random stream.
+    void createSample(int clusterSize, int stratSize, std::mt19937& gen) {
+        clearSample();
 
         switch (strategy) {
 
             case SamplingStrategy::STRATIFIED: {
-                stratified_sampling(stratSize);
+                stratified_sampling(stratSize, gen);
                 break;
             }
             case SamplingStrategy::CLUSTER: {
-                clusterSampling(clusterSize);
+                clusterSampling(clusterSize, gen);
                 break;
             }
             case SamplingStrategy::COMBINED: {
-                combinedSampling(stratSize);
+                combinedSampling(stratSize, gen);
+                break;
+            }
+            case SamplingStrategy::RESERVOIR: {
+                reservoirSampling(gen);
+                break;
+            }
+            case SamplingStrategy::VALUE_STRATIFIED: {
+                valueStratifiedSampling(stratSize, gen);
                 break;
             }
             default:
@@ -47,22 +69,38 @@ public:
         }
     }
 
+    // Positions only, for an array of length n that is not in memory (e.g. one still to be
+    // streamed): fills getSampleIndices() with what createSample would pick and leaves
+    // getSample() empty. RESERVOIR and VALUE_STRATIFIED need the values and are rejected.
+    void createPositions(int n, int clusterSize, int stratSize, std::mt19937& gen) {
+        if (strategy == SamplingStrategy::RESERVOIR || strategy == SamplingStrategy::VALUE_STRATIFIED) {
+            throw std::invalid_argument("Sampler: strategy needs the array's values");
+        }
+        arr.clear();
+        positionsOf = n;
+        createSample(clusterSize, stratSize, gen);
+        positionsOf = -1;
+    }
+
     struct Cluster {
         int start;
         int end;
     };
 
     void stratified_sampling(int stratLength) {
-        int n = arr.size();
-        sample.clear();
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        stratified_sampling(stratLength, gen);
+    }
+
+    void stratified_sampling(int stratLength, std::mt19937& gen) {
+        int n = length();
+        clearSample();
 
         if (n == 0 || sampleLength <= 0 || stratLength <= 0) {
             return;
         }
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
-
         int num_strata = (n + stratLength - 1) / stratLength;
 
         int per_stratum = sampleLength / num_strata;
@@ -78,20 +116,8 @@ public:
             if (remainder > 0) remainder--;
 
             if (take > 0 && stratum_size > 0) {
-                std::unordered_set<int> chosen_indices;
-                std::uniform_int_distribution<> dis(current_start, current_start + stratum_size - 1);
-
-                while ((int)chosen_indices.size() < take) {
-                    int idx = dis(gen);
-                    chosen_indices.insert(idx);
-                }
-
-                std::vector<int> sorted_indices(chosen_indices.begin(), chosen_indices.end());
-                std::sort(sorted_indices.begin(), sorted_indices.end());
-
-                for (int idx : sorted_indices) {
-                    sample.push_back(arr[idx]);
-                }
+                IndexSelector::selectSorted(current_start, stratum_end, take, gen,
+                                            [&](int idx) { pick(idx); });
             }
 
             current_start = stratum_end;
@@ -99,7 +125,7 @@ public:
 
         if (num_strata > 0) {
             int stratum_size = n - current_start;
-            int need = sampleLength - (int)sample.size();
+            int need = sampleLength - (int)sampleIdx.size();
 
             if (need > 0 && stratum_size > 0) {
                 fill_last_stratum(current_start, n, need, gen);
@@ -108,12 +134,15 @@ public:
     }
 
     void clusterSampling(int clusterSize) {
-        int n = arr.size();
-        sample.clear();
-        if (n == 0 || sampleLength <= 0 || clusterSize <= 0) return;
-
         std::random_device rd;
         std::mt19937 gen(rd());
+        clusterSampling(clusterSize, gen);
+    }
+
+    void clusterSampling(int clusterSize, std::mt19937& gen) {
+        int n = length();
+        clearSample();
+        if (n == 0 || sampleLength <= 0 || clusterSize <= 0) return;
 
         int clusterLength = std::min(clusterSize, sampleLength);
 
@@ -130,7 +159,7 @@ public:
             }
 
             for (int i = cl.start; i < cl.end; ++i) {
-                sample.push_back(arr[i]);
+                pick(i);
             }
             total_selected += cluster_size;
         }
@@ -143,13 +172,16 @@ public:
 
 
     void combinedSampling(int stratSize) {
-        sample.clear();
-
-        const int n = static_cast<int>(arr.size());
-        if (n == 0 || sampleLength <= 0 || stratSize <= 0) return;
-
         std::random_device rd;
         std::mt19937 gen(rd());
+        combinedSampling(stratSize, gen);
+    }
+
+    void combinedSampling(int stratSize, std::mt19937& gen) {
+        clearSample();
+
+        const int n = length();
+        if (n == 0 || sampleLength <= 0 || stratSize <= 0) return;
 
         const auto strataSizes  = computeStrataSizes(n, stratSize);
         const auto strataStarts = computeStrataStarts(strataSizes);
@@ -165,29 +197,153 @@ public:
             const int start = strataStarts[s];
             const int size  = strataSizes[s];
 
-            appendRandomClusterFromStratum(start, size, take, gen, sample);
-            if ((int)sample.size() >= sampleLength) break;
+            appendRandomClusterFromStratum(start, size, take, gen);
+            if ((int)sampleIdx.size() >= sampleLength) break;
         }
 
-        if ((int)sample.size() > sampleLength) {
-            sample.resize(sampleLength);
+        if ((int)sampleIdx.size() > sampleLength) {
+            sample.resize(std::min<size_t>(sample.size(), sampleLength));
+            sampleIdx.resize(sampleLength);
         }
     }
 
 
 
 
+    // Treats the array as a stream: one forward pass, no use of its length up front.
+    void reservoirSampling(std::mt19937& gen) {
+        clearSample();
+        if (arr.empty() || sampleLength <= 0) return;
+
+        ReservoirSampler reservoir(sampleLength, static_cast<std::uint32_t>(gen()));
+        reservoir.pushRange(arr.begin(), arr.end());
+        for (const auto& e : reservoir.entries()) pick(static_cast<int>(e.index));
+    }
+
+
+    // Strata are cells of (position stratum of stratLength) x (value quantile bucket).
+    // Quantile cut points come from a one-pass reservoir sketch of the values; the sample
+    // is allocated proportionally to cell sizes and emitted in index order.
+    void valueStratifiedSampling(int stratLength, std::mt19937& gen) {
+        clearSample();
+        const int n = static_cast<int>(arr.size());
+        if (n == 0 || sampleLength <= 0 || stratLength <= 0) return;
+
+        const std::vector<int> cuts = valueQuantileCuts(gen);
+        const int buckets = static_cast<int>(cuts.size()) + 1;
+        auto bucketOf = [&](int v) {
+            return static_cast<int>(std::upper_bound(cuts.begin(), cuts.end(), v) - cuts.begin());
+        };
+
+        const auto strataSizes  = computeStrataSizes(n, stratLength);
+        const auto strataStarts = computeStrataStarts(strataSizes);
+        const int numStrata = static_cast<int>(strataSizes.size());
+
+        // cell sizes
+        std::vector<int> cellSize(static_cast<size_t>(numStrata) * buckets, 0);
+        for (int s = 0; s < numStrata; ++s) {
+            for (int i = strataStarts[s]; i < strataStarts[s] + strataSizes[s]; ++i) {
+                ++cellSize[static_cast<size_t>(s) * buckets + bucketOf(arr[i])];
+            }
+        }
+
+        const std::vector<int> cellTake = allocateProportionally(cellSize, n, std::min(sampleLength, n));
+
+        // pick ordinals within each cell, then map them to positions in one scan per stratum
+        std::vector<std::vector<int>> chosen(buckets);
+        std::vector<int> seen(buckets), next(buckets);
+        for (int s = 0; s < numStrata; ++s) {
+            for (int b = 0; b < buckets; ++b) {
+                const size_t c = static_cast<size_t>(s) * buckets + b;
+                chosen[b].clear();
+                IndexSelector::selectSorted(0, cellSize[c], cellTake[c], gen,
+                                            [&](int ord) { chosen[b].push_back(ord); });
+                seen[b] = 0;
+                next[b] = 0;
+            }
+            for (int i = strataStarts[s]; i < strataStarts[s] + strataSizes[s]; ++i) {
+                const int b = bucketOf(arr[i]);
+                if (next[b] < (int)chosen[b].size() && chosen[b][next[b]] == seen[b]) {
+                    pick(i);
+                    ++next[b];
+                }
+                ++seen[b];
+            }
+        }
+    }
+
+    int getValueStrata() { return valueStrata; }
+    void setValueStrata(int valueStrata) { this->valueStrata = std::max(1, valueStrata); }
+
     std::vector<int>& getArray() { return arr; }
     int getSampleLength() { return sampleLength; }
     void setSampleLength(int sampleLength) { this->sampleLength = sampleLength; }
-    void setArray( std::vector<int>& array ) { this->arr = array; }
+    void setArray(const std::vector<int>& array) { this->arr = array; }
     SamplingStrategy getStrategy() { return strategy; }
     void setStrategy(SamplingStrategy strategy) { this->strategy = strategy; }
     std::vector<int>& getSample() { return sample; }
+    std::vector<int>& getSampleIndices() { return sampleIdx; }
 
 
 private:
 
+    // Distinct interior cut points of the value distribution, from a reservoir sketch.
+    std::vector<int> valueQuantileCuts(std::mt19937& gen) const {
+        constexpr int SKETCH_SIZE = 1024;
+        ReservoirSampler sketch(SKETCH_SIZE, static_cast<std::uint32_t>(gen()));
+        sketch.pushRange(arr.begin(), arr.end());
+        std::vector<int> values = sketch.sample();
+        std::sort(values.begin(), values.end());
+
+        std::vector<int> cuts;
+        for (int q = 1; q < valueStrata; ++q) {
+            const size_t pos = static_cast<size_t>(static_cast<long long>(q) * values.size() / valueStrata);
+            if (pos == 0 || pos >= values.size()) continue;
+            const int cut = values[pos - 1];
+            if (cuts.empty() || cuts.back() < cut) cuts.push_back(cut);
+        }
+        return cuts;
+    }
+
+    // Largest-remainder allocation of `total` over cells proportional to their sizes.
+    static std::vector<int> allocateProportionally(const std::vector<int>& sizes, int n, int total) {
+        std::vector<int> take(sizes.size(), 0);
+        std::vector<std::pair<double, int>> rest;
+        rest.reserve(sizes.size());
+        int assigned = 0;
+        for (size_t c = 0; c < sizes.size(); ++c) {
+            const double share = static_cast<double>(sizes[c]) / n * total;
+            take[c] = std::min(sizes[c], static_cast<int>(std::floor(share)));
+            assigned += take[c];
+            rest.push_back({share - take[c], static_cast<int>(c)});
+        }
+        std::sort(rest.begin(), rest.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        for (size_t k = 0; k < rest.size() && assigned < total; ++k) {
+            const int c = rest[k].second;
+            if (take[c] < sizes[c]) {
+                ++take[c];
+                ++assigned;
+            }
+        }
+        return take;
+    }
+
+    void clearSample() {
+        sample.clear();
+        sampleIdx.clear();
+    }
+
+    int length() const {
+        return positionsOf >= 0 ? positionsOf : static_cast<int>(arr.size());
+    }
+
+    void pick(int idx) {
+        if (positionsOf < 0) sample.push_back(arr[idx]);
+        sampleIdx.push_back(idx);
+    }
+
     bool intersects(const Cluster &a, const Cluster &b) {
         return !(a.end <= b.start || b.end <= a.start);
     }
@@ -241,20 +397,8 @@ private:
         int interval_size = end_after_last - start_after_last;
 
         if (interval_size >= remaining) {
-
-
-            std::uniform_int_distribution<> dis(start_after_last, end_after_last - 1);
-            std::unordered_set<int> chosen;
-            while ((int)chosen.size() < remaining) {
-                chosen.insert(dis(gen));
-            }
-
-            candidates.assign(chosen.begin(), chosen.end());
-            std::sort(candidates.begin(), candidates.end());
-
-            for (int idx : candidates) {
-                sample.push_back(arr[idx]);
-            }
+            IndexSelector::selectSorted(start_after_last, end_after_last, remaining, gen,
+                                        [&](int idx) { pick(idx); });
             return;
         }
 
@@ -275,7 +419,7 @@ private:
 
         std::sort(candidates.begin(), candidates.end());
         for (int idx : candidates) {
-            sample.push_back(arr[idx]);
+            pick(idx);
         }
     }
 
@@ -293,7 +437,7 @@ private:
 
         for (int i = 0; i < need; i++) {
             int idx = start + i;
-            sample.push_back(arr[idx]);
+            pick(idx);
         }
     }
 
@@ -360,14 +504,15 @@ private:
 }
 
     void appendRandomClusterFromStratum(int stratumStart, int stratumSize, int take,
-                                    std::mt19937& gen, std::vector<int>& out) const {
+                                    std::mt19937& gen) {
     if (take <= 0 || stratumSize <= 0) return;
     take = std::min(take, stratumSize);
     const int maxStart = stratumSize - take;
     std::uniform_int_distribution<int> dis(0, maxStart);
     const int start = stratumStart + dis(gen);
-    out.reserve(out.size() + take);
-    for (int j = 0; j < take; ++j) out.push_back(arr[start + j]);
+    sample.reserve(sample.size() + take);
+    sampleIdx.reserve(sampleIdx.size() + take);
+    for (int j = 0; j < take; ++j) pick(start + j);
 }
 
 
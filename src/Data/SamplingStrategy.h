@@ -6,7 +6,9 @@
 enum class SamplingStrategy {
    STRATIFIED,
    CLUSTER,
-   COMBINED
+   COMBINED,
+   RESERVOIR,
+   VALUE_STRATIFIED
 };
 
 #endif //SAMPLINGSTRATEGY_H
@@ -3,10 +3,19 @@
 // абсолютные пути, как просил
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/DataGenerator.h"
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/DisorderMetrics.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/ExperimentConfigurator.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/ArrayStream.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/ParallelShuffle.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/ReservoirSampler.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/ExperimentPlanner.h"
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <set>
+#include <sstream>
 #include <unordered_map>
 
 class DataGeneratorTest : public ::testing::Test {
@@ -31,11 +40,579 @@ TEST_F(DataGeneratorTest, GenerateRuns_MatchesRequested) {
     }
 }
 
+TEST_F(DataGeneratorTest, GenerateRandom_WideRangeKDistinct) {
+    DataGenerator g;
+
+    // full int range: value selection must not materialize the range
+    const int lo = std::numeric_limits<int>::min();
+    const int hi = std::numeric_limits<int>::max();
+    for (int k : {1, 7, 1000}) {
+        auto arr = g.generateRandom(N, lo, hi, k);
+        ASSERT_EQ((int)arr.size(), N);
+        std::vector<int> distinct = arr;
+        std::sort(distinct.begin(), distinct.end());
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+        EXPECT_LE((int)distinct.size(), k);
+        EXPECT_GE((int)distinct.size(), std::min(k, 900));
+    }
+
+    // k == range picks every value exactly once into the pool
+    auto pool = g.chooseDistinctValues(5, 14, 10);
+    std::sort(pool.begin(), pool.end());
+    std::vector<int> expected(10);
+    std::iota(expected.begin(), expected.end(), 5);
+    EXPECT_EQ(pool, expected);
+
+    EXPECT_THROW(g.chooseDistinctValues(0, 9, 11), std::invalid_argument);
+}
+
+TEST_F(DataGeneratorTest, GenerateRuns_ExtremesAndBounds) {
+    DataGenerator g;
+
+    // every element its own run: strictly decreasing across the whole array
+    auto arr = g.generateRuns(N, N, MINV, MAXV);
+    ASSERT_EQ((int)arr.size(), N);
+    EXPECT_EQ(dm.calculateRuns(arr), N);
+    EXPECT_GE(*std::min_element(arr.begin(), arr.end()), MINV);
+    EXPECT_LE(*std::max_element(arr.begin(), arr.end()), MAXV);
+
+    // tightest feasible range has exactly one solution
+    auto tight = g.generateRuns(10, 10, 0, 9);
+    EXPECT_EQ(tight, (std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0}));
+
+    // a single run may be constant
+    auto flat = g.generateRuns(100, 1, 3, 3);
+    EXPECT_EQ(flat, std::vector<int>(100, 3));
 
+    EXPECT_THROW(g.generateRuns(10, 10, 0, 8), std::invalid_argument);
+    EXPECT_THROW(g.generateRuns(5, 6, MINV, MAXV), std::invalid_argument);
+}
+
+TEST_F(DataGeneratorTest, SeededSets_IndependentOfThreadCount) {
+    ExperimentConfigurator::Config cfg{1000, 50, 0, 1000, ""};
+    cfg.masterSeed = 12345;
+
+    auto build = [&](unsigned threads) {
+        cfg.threads = threads;
+        ExperimentConfigurator exp(cfg);
+        return exp.generateArrays("run_array/1000/r/10", 37, [](DataGenerator& gen) {
+            return gen.generateRuns(1000, 10, 0, 1000);
+        });
+    };
+
+    const auto serial = build(1);
+    ASSERT_EQ(serial.size(), 37u);
+    EXPECT_EQ(build(4), serial);
+    EXPECT_EQ(build(64), serial);
+    EXPECT_NE(serial[0], serial[1]);
+
+    // a single array can be regenerated from its substream alone
+    DataGenerator a(DataGenerator::substreamSeed(7, 3));
+    DataGenerator b(DataGenerator::substreamSeed(7, 3));
+    EXPECT_EQ(a.generatePermutation(100), b.generatePermutation(100));
+}
 
+TEST_F(DataGeneratorTest, TargetDisorder_ExactValues) {
+    DataGenerator g(2024);
+    const size_t n = 2000;
 
+    auto isPermutation = [](std::vector<int> a) {
+        std::sort(a.begin(), a.end());
+        for (size_t i = 0; i < a.size(); ++i) if (a[i] != (int)i + 1) return false;
+        return true;
+    };
 
+    const long long maxInv = (long long)n * (n - 1) / 2;
+    for (long long inv : {0LL, 1LL, 12345LL, maxInv / 2, maxInv - 1, maxInv}) {
+        auto a = g.generateWithInversions(n, inv);
+        ASSERT_TRUE(isPermutation(a));
+        EXPECT_EQ(dm.calculateInversions(a), inv);
+    }
+    for (size_t rem : {size_t(1), size_t(2), size_t(45), n / 2, n}) {
+        auto a = g.generateWithRem(n, rem);
+        ASSERT_TRUE(isPermutation(a));
+        EXPECT_EQ(dm.calculateRem(a), (long long)rem);
+    }
+    for (size_t osc : {size_t(0), size_t(1), size_t(500), n - 3, n - 2}) {
+        auto a = g.generateWithOsc(n, osc);
+        ASSERT_TRUE(isPermutation(a));
+        EXPECT_EQ(dm.calculateOsc(a), (long long)osc);
+    }
+    for (size_t m : {size_t(0), size_t(1), size_t(17), n - 1}) {
+        auto a = g.generateWithMaxDisplacement(n, m);
+        ASSERT_TRUE(isPermutation(a));
+        EXPECT_EQ(dm.calculateMax(a), (long long)m);
+    }
+
+    EXPECT_THROW(g.generateWithInversions(n, maxInv + 1), std::invalid_argument);
+    EXPECT_THROW(g.generateWithRem(n, 0), std::invalid_argument);
+    EXPECT_THROW(g.generateWithOsc(n, n - 1), std::invalid_argument);
+    EXPECT_THROW(g.generateWithMaxDisplacement(n, n), std::invalid_argument);
+}
 
+TEST_F(DataGeneratorTest, ArrayStream_ChunkedMatchesWholeAndKeepsShape) {
+    const size_t n = 10007;
 
+    auto collect = [&](ArrayType type, size_t chunk, int runs, int k) {
+        auto stream = ArrayStream::make(type, n, MINV, MAXV, runs, k, 99);
+        std::vector<int> out;
+        stream->drain(chunk, [&](std::span<const int> c) { out.insert(out.end(), c.begin(), c.end()); });
+        EXPECT_EQ(stream->remaining(), 0u);
+        return out;
+    };
 
+    // chunk boundaries must not change the values (runs state crosses chunks)
+    for (ArrayType t : {ArrayType::PERMUTATION_ARRAY, ArrayType::RANDOM_ARRAY, ArrayType::SORTED_ARRAY,
+                        ArrayType::REVERSE_ARRAY, ArrayType::RUNS_ARRAY}) {
+        EXPECT_EQ(collect(t, 1, 100, 50), collect(t, 4096, 100, 50));
+    }
+
+    auto perm = collect(ArrayType::PERMUTATION_ARRAY, 333, 0, 0);
+    std::vector<int> sorted = perm;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < n; ++i) ASSERT_EQ(sorted[i], (int)i + 1);
+
+    for (int runs : {1, 7, 100, 2500}) {
+        EXPECT_EQ(dm.calculateRuns(collect(ArrayType::RUNS_ARRAY, 1000, runs, 0)), runs);
+    }
+    auto tight = ArrayStream::make(ArrayType::RUNS_ARRAY, 10, 0, 9, 10, 0, 1);
+    std::vector<int> all(10);
+    ASSERT_EQ(tight->next(all), 10u);
+    EXPECT_EQ(all, (std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0}));
+
+    // workloads take their parameter as k; only the interleaved shape has no stream
+    for (ArrayType t : {ArrayType::NEARLY_SORTED_ARRAY, ArrayType::SORTED_TAIL_ARRAY, ArrayType::SAWTOOTH_ARRAY,
+                        ArrayType::ORGAN_PIPE_ARRAY, ArrayType::ZIPF_ARRAY}) {
+        EXPECT_EQ(collect(t, 1, 0, 50), collect(t, 4096, 0, 50));
+    }
+    auto isPermutation = [&](std::vector<int> a) {
+        std::sort(a.begin(), a.end());
+        for (size_t i = 0; i < a.size(); ++i) if (a[i] != (int)i + 1) return false;
+        return a.size() == n;
+    };
+    auto nearly = collect(ArrayType::NEARLY_SORTED_ARRAY, 1000, 0, 5);
+    EXPECT_TRUE(isPermutation(nearly));
+    EXPECT_LE(dm.calculateHam(nearly), 10);
+    auto tail = collect(ArrayType::SORTED_TAIL_ARRAY, 1000, 0, 50);
+    EXPECT_TRUE(isPermutation(tail));
+    EXPECT_TRUE(std::is_sorted(tail.begin(), tail.end() - 50));
+    auto saw = collect(ArrayType::SAWTOOTH_ARRAY, 1000, 0, 100);
+    for (size_t i = 1; i < n; ++i) ASSERT_EQ(saw[i], saw[i - 1] == 100 ? 1 : saw[i - 1] + 1);
+    auto pipes = collect(ArrayType::ORGAN_PIPE_ARRAY, 1000, 0, 3);
+    EXPECT_EQ(std::count(pipes.begin(), pipes.end(), 1), 6); // each pipe starts and ends at 1
+    EXPECT_THROW(ArrayStream::make(ArrayType::INTERLEAVED_ARRAY, n, MINV, MAXV, 0, 4, 1), std::invalid_argument);
+
+    auto random = collect(ArrayType::RANDOM_ARRAY, 512, 0, 50);
+    std::sort(random.begin(), random.end());
+    EXPECT_LE(std::unique(random.begin(), random.end()) - random.begin(), 50);
+
+    // sinks: a reservoir sample fed chunk by chunk
+    ReservoirSampler reservoir(100, 5);
+    ArrayStream::make(ArrayType::SORTED_ARRAY, n, MINV, 1000000, 0, 0, 3)
+        ->drain(777, [&](std::span<const int> c) { reservoir.pushRange(c.begin(), c.end()); });
+    EXPECT_EQ(reservoir.getSeen(), (long long)n);
+    EXPECT_EQ(reservoir.sample().size(), 100u);
+}
+
+TEST_F(DataGeneratorTest, Workloads_Shapes) {
+    DataGenerator g(11);
+    const size_t n = 1000;
+
+    auto isPermutation = [](std::vector<int> a) {
+        std::sort(a.begin(), a.end());
+        for (size_t i = 0; i < a.size(); ++i) if (a[i] != (int)i + 1) return false;
+        return true;
+    };
+
+    auto nearly = g.generateNearlySorted(n, 5);
+    EXPECT_TRUE(isPermutation(nearly));
+    EXPECT_LE(dm.calculateHam(nearly), 10);
+    // a single swap always moves two elements
+    for (int rep = 0; rep < 50; ++rep) EXPECT_EQ(dm.calculateHam(g.generateNearlySorted(10, 1)), 2);
+
+    auto tail = g.generateSortedWithTail(n, 50);
+    EXPECT_TRUE(isPermutation(tail));
+    EXPECT_TRUE(std::is_sorted(tail.begin(), tail.end() - 50));
+
+    // the phase is random: a partial first tooth adds a run
+    auto saw = g.generateSawtooth(n, 100);
+    EXPECT_EQ(dm.calculateRuns(saw), saw[0] == 1 ? 10 : 11);
+    for (size_t i = 1; i < n; ++i) ASSERT_EQ(saw[i], saw[i - 1] == 100 ? 1 : saw[i - 1] + 1);
+
+    // each pipe rises from 1 to a peak in its middle half, then falls to 1
+    std::set<int> peaks;
+    for (int rep = 0; rep < 20; ++rep) {
+        auto pipe = g.generateOrganPipe(20, 1);
+        const auto top = std::max_element(pipe.begin(), pipe.end()) - pipe.begin();
+        EXPECT_GE(top, 5);
+        EXPECT_LE(top, 14);
+        EXPECT_EQ(pipe.front(), 1);
+        EXPECT_EQ(pipe.back(), 1);
+        EXPECT_TRUE(std::is_sorted(pipe.begin(), pipe.begin() + top + 1));
+        EXPECT_TRUE(std::is_sorted(pipe.begin() + top, pipe.end(), std::greater<>()));
+        peaks.insert(static_cast<int>(top));
+    }
+    EXPECT_GT(peaks.size(), 1u);
+
+    auto zipf = g.generateZipf(20000, 0, 1000000, 50);
+    std::unordered_map<int, int> freq;
+    for (int v : zipf) ++freq[v];
+    int top = 0;
+    for (const auto& [v, c] : freq) top = std::max(top, c);
+    EXPECT_LE((int)freq.size(), 50);
+    EXPECT_GT(top, 20000 / 10); // rank 1 carries ~22% of the mass
+
+    auto inter = g.generateInterleaved(n, 4);
+    EXPECT_TRUE(isPermutation(inter));
+    for (size_t i = 4; i < n; ++i) ASSERT_LT(inter[i - 4], inter[i]);
+
+    // every workload type goes through the dispatcher, deterministically per seed
+    for (ArrayType t : {ArrayType::NEARLY_SORTED_ARRAY, ArrayType::SORTED_TAIL_ARRAY, ArrayType::SAWTOOTH_ARRAY,
+                        ArrayType::ORGAN_PIPE_ARRAY, ArrayType::ZIPF_ARRAY, ArrayType::INTERLEAVED_ARRAY}) {
+        DataGenerator a(3), b(3);
+        auto x = a.generateWorkload(t, n, MINV, MAXV, 7);
+        EXPECT_EQ(x.size(), n);
+        EXPECT_EQ(x, b.generateWorkload(t, n, MINV, MAXV, 7));
+    }
+    EXPECT_THROW(g.generateWorkload(ArrayType::RUNS_ARRAY, n, MINV, MAXV, 7), std::invalid_argument);
+}
+
+TEST_F(DataGeneratorTest, SpanAndBufferOverloads_MatchVectorVersions) {
+    // the vector-returning generators against the span dispatch and generate_Data
+    const std::vector<std::pair<ArrayType, std::function<std::vector<int>(DataGenerator&)>>> cases = {
+        {ArrayType::PERMUTATION_ARRAY, [](DataGenerator& g) { return g.generatePermutation(N); }},
+        {ArrayType::RANDOM_ARRAY, [](DataGenerator& g) { return g.generateRandom(N, MINV, MAXV, 30); }},
+        {ArrayType::SORTED_ARRAY, [](DataGenerator& g) { return g.generateSorted(N, MINV, MAXV); }},
+        {ArrayType::REVERSE_ARRAY, [](DataGenerator& g) { return g.generateReverseSorted(N, MINV, MAXV); }},
+        {ArrayType::RUNS_ARRAY, [](DataGenerator& g) { return g.generateRuns(N, 50, MINV, MAXV); }},
+        {ArrayType::NEARLY_SORTED_ARRAY, [](DataGenerator& g) { return g.generateNearlySorted(N, 30); }},
+        {ArrayType::SORTED_TAIL_ARRAY, [](DataGenerator& g) { return g.generateSortedWithTail(N, 30); }},
+        {ArrayType::INTERLEAVED_ARRAY, [](DataGenerator& g) { return g.generateInterleaved(N, 30); }},
+    };
+    for (const auto& [t, make] : cases) {
+        DataGenerator a(21), b(21), c(21);
+        const auto expected = make(a);
+        std::vector<int> span(N);
+        b.generate(t, std::span<int>(span), MINV, MAXV, 50, 30);
+        EXPECT_EQ(span, expected);
+        c.generate_Data(t, N, MINV, MAXV, 50, 30);
+        EXPECT_EQ(c.getInput(), expected);
+    }
 
+    // zero runs is the empty array through every entry point; a non-empty span cannot hold it
+    DataGenerator zero(1);
+    EXPECT_TRUE(zero.generateRuns(N, 0, MINV, MAXV).empty());
+    zero.generate_Data(ArrayType::RUNS_ARRAY, N, MINV, MAXV, 0, 0);
+    EXPECT_TRUE(zero.getInput().empty());
+    std::vector<int> nonEmpty(N);
+    EXPECT_THROW(zero.generateRuns(std::span<int>(nonEmpty), 0, MINV, MAXV), std::invalid_argument);
+
+    // reusing a buffer keeps its memory
+    DataGenerator g(5);
+    std::vector<int> buffer;
+    g.generate(ArrayType::RUNS_ARRAY, buffer, N, MINV, MAXV, 100, 0);
+    const int* data = buffer.data();
+    for (int rep = 0; rep < 3; ++rep) {
+        g.generate(ArrayType::RUNS_ARRAY, buffer, N, MINV, MAXV, 100, 0);
+        ASSERT_EQ(buffer.data(), data);
+        EXPECT_EQ(dm.calculateRuns(buffer), 100);
+    }
+
+    // run lengths parked in the tail of the span must not leak into the values
+    std::vector<int> one(N);
+    g.generateRuns(std::span<int>(one), N, MINV, MAXV);
+    EXPECT_EQ(dm.calculateRuns(one), N);
+
+    std::vector<int> inter(1001);
+    g.generateInterleaved(std::span<int>(inter), 7);
+    for (size_t i = 7; i < inter.size(); ++i) ASSERT_LT(inter[i - 7], inter[i]);
+}
+
+TEST_F(DataGeneratorTest, ParallelShuffle_ReproducibleAcrossThreadCounts) {
+    const size_t n = ParallelShuffle::MIN_PARALLEL * 4 + 123;
+
+    auto run = [&](unsigned threads) {
+        DataGenerator g(77);
+        g.setThreads(threads);
+        return g.generatePermutation(n);
+    };
+
+    const auto serial = run(1);
+    EXPECT_EQ(run(3), serial);
+    EXPECT_EQ(run(8), serial);
+
+    std::vector<int> sorted = serial;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < n; ++i) ASSERT_EQ(sorted[i], (int)i + 1);
+
+    // well mixed: about n/2 descents, and front values spread over the whole range
+    const double descentRate = (double)(dm.calculateRuns(serial) - 1) / (double)(n - 1);
+    EXPECT_NEAR(descentRate, 0.5, 0.01);
+    long long frontSum = 0;
+    for (size_t i = 0; i < 10000; ++i) frontSum += serial[i];
+    EXPECT_NEAR((double)frontSum / 10000.0, (double)n / 2.0, (double)n * 0.02);
+}
+
+TEST_F(DataGeneratorTest, ShardedSets_ResumeAndMatchSingleRun) {
+    namespace fs = std::filesystem;
+    const fs::path tmp = fs::temp_directory_path() / "disorder_shard_test";
+    fs::remove_all(tmp);
+
+    auto config = [&](const fs::path& root) {
+        ExperimentConfigurator::Config cfg{200, 20, 0, 1000, root.generic_string()};
+        cfg.masterSeed = 99;
+        cfg.shardSize = 3;
+        cfg.threads = 2;
+        return cfg;
+    };
+    auto slurp = [](const fs::path& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+
+    // reference: one process, all shards
+    ExperimentConfigurator(config(tmp / "one")).generateRunsSet(9, 8);
+
+    // two workers; worker 1 finds a half-written shard left by an interrupted run
+    auto cfg = config(tmp / "split");
+    cfg.shardWorkers = 2;
+    cfg.shardWorker = 0;
+    ExperimentConfigurator(cfg).generateRunsSet(9, 8);
+    const fs::path set = tmp / "split" / "run_array" / "200" / "r" / "r_9";
+    EXPECT_TRUE(fs::exists(set / "shards" / "00000" / "_DONE"));
+    EXPECT_FALSE(fs::exists(set / "_DONE"));
+    fs::create_directories(set / "shards" / "00001");
+    std::ofstream(set / "shards" / "00001" / "arrays.csv") << "garbage\n";
+
+    // the seed is picked up from the root on resume
+    cfg.masterSeed.reset();
+    cfg.shardWorker = 1;
+    ExperimentConfigurator resumed(cfg);
+    EXPECT_EQ(resumed.getSeed(), 99u);
+    // while another worker holds the merge, this one only builds its shards
+    fs::create_directory(set / ".merging");
+    resumed.generateRunsSet(9, 8);
+    EXPECT_TRUE(fs::exists(set / "shards" / "00001" / "_DONE"));
+    EXPECT_FALSE(fs::exists(set / "_DONE"));
+    fs::remove(set / ".merging");
+    resumed.generateRunsSet(9, 8);
+
+    const fs::path ref = tmp / "one" / "run_array" / "200" / "r" / "r_9";
+    EXPECT_TRUE(fs::exists(set / "_DONE"));
+    EXPECT_FALSE(fs::exists(set / "shards"));
+    EXPECT_FALSE(fs::exists(set / ".merging"));
+    EXPECT_EQ(slurp(set / "arrays.csv"), slurp(ref / "arrays.csv"));
+    const fs::path sample = fs::path("samples") / "sqrt n" / "cluster sampling" / "sqrt smlLength" / "samples.csv";
+    EXPECT_EQ(slurp(set / sample), slurp(ref / sample));
+    // index mode writes the positions of the same samples instead of their values
+    const fs::path idx = fs::path(sample).replace_filename("samples.idx");
+    EXPECT_FALSE(fs::exists(set / idx));
+    auto idxCfg = config(tmp / "idx");
+    idxCfg.indexOnlySamples = true;
+    ExperimentConfigurator(idxCfg).generateRunsSet(9, 8);
+    const fs::path idxSet = tmp / "idx" / "run_array" / "200" / "r" / "r_9";
+    EXPECT_FALSE(fs::exists(idxSet / sample));
+    {
+        std::ifstream arrays(idxSet / "arrays.csv"), values(ref / sample);
+        std::ifstream positions(idxSet / idx, std::ios::binary);
+        std::vector<int> arr, expected, indices;
+        int rows = 0;
+        while (Evaluator::readNextRow(arrays, arr)) {
+            ASSERT_TRUE(Evaluator::readNextRow(values, expected));
+            ASSERT_TRUE(SampleCodec::readRow(positions, indices));
+            EXPECT_EQ(SampleCodec::gather(arr, indices), expected);
+            ++rows;
+        }
+        EXPECT_EQ(rows, 8);
+    }
+
+    std::string csv = slurp(set / "arrays.csv");
+    EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'), 8);
+
+    // value-stratified groups get their own folders, which the Evaluator maps back
+    auto valueCfg = config(tmp / "value");
+    valueCfg.valueStratified = true;
+    ExperimentConfigurator(valueCfg).generateRunsSet(9, 8);
+    const fs::path samples = tmp / "value" / "run_array" / "200" / "r" / "r_9" / "samples" / "sqrt n";
+    const std::string values = slurp(samples / "value stratified sampling" / "smlLength" / "samples.csv");
+    EXPECT_EQ(std::count(values.begin(), values.end(), '\n'), 8);
+    EXPECT_EQ(Evaluator::strategyFromPath(samples / "value stratified sampling" / "smlLength"),
+              SamplingStrategy::VALUE_STRATIFIED);
+    EXPECT_EQ(Evaluator::strategyFromPath(samples / "stratified sampling" / "smlLength"),
+              SamplingStrategy::STRATIFIED);
+
+    auto other = config(tmp / "split");
+    other.masterSeed = 100;
+    EXPECT_THROW(ExperimentConfigurator{other}, std::runtime_error);
+
+    fs::remove_all(tmp);
+}
+
+TEST_F(DataGeneratorTest, StreamedSets_WriteArraysAndAllPositionalSamples) {
+    namespace fs = std::filesystem;
+    const fs::path tmp = fs::temp_directory_path() / "disorder_stream_test";
+    fs::remove_all(tmp);
+
+    // the same set once with values, once with positions
+    ExperimentConfigurator::Config cfg{200, 20, 0, 1000, (tmp / "csv").generic_string()};
+    cfg.masterSeed = 5;
+    cfg.streamAbove = 100;
+    ExperimentConfigurator(cfg).generateRunsSet(9, 4);
+    cfg.root = (tmp / "idx").generic_string();
+    cfg.indexOnlySamples = true;
+    ExperimentConfigurator(cfg).generateRunsSet(9, 4);
+    // in memory, the positional groups draw the same positions
+    cfg.root = (tmp / "mem").generic_string();
+    cfg.streamAbove = 1 << 24;
+    ExperimentConfigurator(cfg).generateRunsSet(9, 4);
+
+    const fs::path rel = fs::path("run_array") / "200" / "r" / "r_9";
+    const fs::path set = tmp / "csv" / rel;
+    const fs::path dir = fs::path("samples") / "sqrt n" / "reservoir sampling";
+    const fs::path cluster = fs::path("samples") / "sqrt n" / "cluster sampling" / "sqrt smlLength";
+    const fs::path combined = fs::path("samples") / "sqrt n" / "combined sampling" / "n div 10";
+    EXPECT_TRUE(fs::exists(set / "_DONE"));
+    auto slurp = [](const fs::path& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+    for (const fs::path& group : {cluster, combined, fs::path("samples") / "sqrt n" / "stratified sampling" / "n div 4"}) {
+        EXPECT_FALSE(slurp(tmp / "idx" / rel / group / "samples.idx").empty()) << group;
+        EXPECT_EQ(slurp(tmp / "idx" / rel / group / "samples.idx"), slurp(tmp / "mem" / rel / group / "samples.idx")) << group;
+    }
+
+    std::ifstream arrays(set / "arrays.csv");
+    std::ifstream idx(tmp / "idx" / rel / dir / "samples.idx", std::ios::binary);
+    std::ifstream csv(set / dir / "samples.csv");
+    std::ifstream clusterIdx(tmp / "idx" / rel / cluster / "samples.idx", std::ios::binary);
+    std::ifstream clusterCsv(set / cluster / "samples.csv");
+    std::ifstream combinedIdx(tmp / "idx" / rel / combined / "samples.idx", std::ios::binary);
+    std::ifstream combinedCsv(set / combined / "samples.csv");
+    std::string line, sampleLine;
+    int rows = 0;
+    while (std::getline(arrays, line)) {
+        std::vector<int> arr;
+        std::stringstream ss(line);
+        for (std::string cell; std::getline(ss, cell, ',');) arr.push_back(std::stoi(cell));
+        ASSERT_EQ((int)arr.size(), 200);
+        EXPECT_EQ(dm.calculateRuns(arr), 9);
+
+        // the reservoir sample is the array at the recorded positions
+        std::vector<int> positions;
+        ASSERT_TRUE(SampleCodec::readRow(idx, positions));
+        ASSERT_EQ((int)positions.size(), 20);
+        ASSERT_TRUE(std::getline(csv, sampleLine));
+        std::vector<int> sample;
+        std::stringstream sampleSs(sampleLine);
+        for (std::string cell; std::getline(sampleSs, cell, ',');) sample.push_back(std::stoi(cell));
+        EXPECT_EQ(sample, SampleCodec::gather(arr, positions));
+
+        // so are the positional samples picked up while streaming
+        ASSERT_TRUE(SampleCodec::readRow(clusterIdx, positions));
+        ASSERT_TRUE(Evaluator::readNextRow(clusterCsv, sample));
+        EXPECT_EQ(sample, SampleCodec::gather(arr, positions));
+        ASSERT_TRUE(SampleCodec::readRow(combinedIdx, positions));
+        ASSERT_TRUE(Evaluator::readNextRow(combinedCsv, sample));
+        EXPECT_EQ(sample, SampleCodec::gather(arr, positions));
+        ++rows;
+    }
+    EXPECT_EQ(rows, 4);
+
+    fs::remove_all(tmp);
+}
+
+TEST_F(DataGeneratorTest, ExperimentSpec_PlansDedupedDagAndMatchesConfigurator) {
+    namespace fs = std::filesystem;
+    const fs::path tmp = fs::temp_directory_path() / "disorder_spec_test";
+    fs::remove_all(tmp);
+
+    // 14 == floor(sqrt(200)): both run entries and both sizes name the same sets
+    std::stringstream text;
+    text << "root = " << (tmp / "in").generic_string() << "\n"
+         << "output = " << (tmp / "out").generic_string() << "  # evaluation\n"
+         << "seed = 7\nthreads = 3\n"
+         << "sizes = 200, 200\ncount = 5\nsample_size = 20\nmax_value = n div 2\n"
+         << "types = runs, permutation\nruns = 14, sqrt n\n"
+         << "cluster_groups = sqrt\nstratum_groups = n div 10\n"
+         << "metrics = inv, rem\nevaluate = metrics, accuracy\nshard_size = 2\n";
+    const ExperimentSpec spec = ExperimentSpec::parse(text);
+    EXPECT_EQ(ExperimentSpec::resolve(spec.maxValue, 200), 100);
+
+    {
+        ExperimentPlanner planner(spec);
+        // 2 sets x (3 shards + merge + metrics) + accuracy
+        ASSERT_EQ(planner.tasks().size(), 11u);
+        std::set<std::string> names;
+        for (size_t t = 0; t < planner.tasks().size(); ++t) {
+            names.insert(planner.tasks()[t].name);
+            for (size_t d : planner.tasks()[t].deps) EXPECT_LT(d, t);
+        }
+        EXPECT_EQ(names.size(), 11u);
+        EXPECT_EQ(planner.tasks().back().name, "accuracy");
+        EXPECT_EQ(planner.tasks().back().deps.size(), 2u);
+        planner.run();
+    }
+
+    // same bytes as a sequential build with the same settings
+    ExperimentConfigurator::Config cfg{200, 20, 0, 100, (tmp / "ref").generic_string()};
+    cfg.masterSeed = 7;
+    cfg.clusterGroups = {"sqrt"};
+    cfg.stratumGroups = {"n div 10"};
+    ExperimentConfigurator(cfg).generateRunsSet(14, 5);
+    auto slurp = [](const fs::path& p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+    const fs::path set = fs::path("run_array") / "200" / "r" / "sqrt n";
+    EXPECT_EQ(slurp(tmp / "in" / set / "arrays.csv"), slurp(tmp / "ref" / set / "arrays.csv"));
+    // the metrics filter narrows the metric tables too
+    std::ifstream arraysMetrics(tmp / "out" / set / "arrays_metrics.csv");
+    std::string header;
+    ASSERT_TRUE(std::getline(arraysMetrics, header));
+    EXPECT_EQ(header, "n,inv_norm,rem_norm");
+
+    std::ifstream acc(tmp / "out" / "sampling_accuracy.csv");
+    std::string line;
+    std::getline(acc, line);
+    int rows = 0;
+    while (std::getline(acc, line)) {
+        ++rows;
+        EXPECT_TRUE(line.find(",inv,") != std::string::npos || line.find(",rem,") != std::string::npos) << line;
+    }
+    // 2 sets x 3 groups x (inv from both sources + rem from the sample; rem has no estimator)
+    EXPECT_EQ(rows, 18);
+
+    // a rerun only re-evaluates
+    ExperimentPlanner again(spec);
+    for (const auto& task : again.tasks()) EXPECT_EQ(task.name.find("shard:"), std::string::npos);
+
+    // adaptive sampling of the generated arrays; rem has no estimator, so only inv
+    std::stringstream adaptiveText;
+    adaptiveText << text.str() << "evaluate = adaptive\nadaptive_strategy = cluster\n"
+                 << "adaptive_target = 0.05\nadaptive_budget = n div 2\n";
+    ExperimentPlanner adaptive(ExperimentSpec::parse(adaptiveText));
+    ASSERT_EQ(adaptive.tasks().size(), 2u);
+    EXPECT_EQ(adaptive.tasks().front().name.rfind("adaptive:", 0), 0u);
+    adaptive.run();
+    std::ifstream adaptiveCsv(tmp / "out" / set / "adaptive_estimates.csv");
+    ASSERT_TRUE(std::getline(adaptiveCsv, header));
+    EXPECT_EQ(header, "array,rounds,n,converged,inv_est,inv_se,inv_lo,inv_hi");
+    rows = 0;
+    while (std::getline(adaptiveCsv, line)) {
+        std::stringstream cells(line);
+        std::string cell;
+        std::getline(cells, cell, ',');
+        EXPECT_EQ(std::stoi(cell), rows++);
+        std::getline(cells, cell, ',');
+        std::getline(cells, cell, ',');
+        EXPECT_LE(std::stoi(cell), 100);
+    }
+    EXPECT_EQ(rows, 5);
+
+    std::stringstream bad("root = x\nsizes = 10\ntypes = runs\nruns = 3\nbogus = 1\n");
+    EXPECT_THROW(ExperimentSpec::parse(bad), std::runtime_error);
+    std::stringstream badExpr("root = x\nsizes = 10\ntypes = random\nk = n div 0\n");
+    EXPECT_THROW(ExperimentSpec::parse(badExpr), std::runtime_error);
+
+    fs::remove_all(tmp);
+}
@@ -0,0 +1,220 @@
+#ifndef ESTIMATORTEST_H
+#define ESTIMATORTEST_H
+
+#include <gtest/gtest.h>
+
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/AdaptiveSampler.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/Estimator.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/Evaluator.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/DataGenerator.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/Sampler.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class EstimatorTest : public ::testing::Test {
+protected:
+    static constexpr int N = 10000;
+    static constexpr int SAMPLE = 400;
+
+    DisorderMetrics dm;
+};
+
+TEST_F(EstimatorTest, SplitUnits_ConsecutivePositions) {
+    EXPECT_EQ(Estimator::splitUnits({3, 4, 5, 9, 20, 21}, 6), (std::vector<int>{3, 1, 2}));
+    EXPECT_EQ(Estimator::splitUnits({}, 3), (std::vector<int>{1, 1, 1}));
+}
+
+TEST_F(EstimatorTest, Stratified_CoversFullArrayInversions) {
+    DataGenerator gen;
+    auto arr = gen.generatePermutation(N);
+    const double truth = dm.normalizeInversions(dm.calculateInversions(arr), N);
+
+    Sampler s(arr, SAMPLE);
+    s.setStrategy(SamplingStrategy::STRATIFIED);
+    s.createSample(0, N / 20);
+
+    Estimator est(SamplingStrategy::STRATIFIED, 300, 0.99, 17);
+    const auto e = est.estimate(s.getSample(), s.getSampleIndices());
+    const auto& inv = e[Metric::Inversions];
+    EXPECT_LE(inv.lo, inv.value);
+    EXPECT_GE(inv.hi, inv.value);
+    EXPECT_GT(inv.stdError, 0.0);
+    EXPECT_NEAR(inv.value, truth, 0.1);
+}
+
+TEST_F(EstimatorTest, Cluster_CorrectsLocalBias) {
+    // Ascending blocks of 200 in shuffled block order: inside a cluster everything looks
+    // sorted, so the plug-in value underestimates; cross-cluster pairs do not.
+    std::mt19937 rng(2024);
+    const int block = 200;
+    std::vector<int> order(N / block);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<int> arr;
+    for (int b : order) for (int i = 0; i < block; ++i) arr.push_back(b * block + i);
+
+    const double truthInv  = dm.normalizeInversions(dm.calculateInversions(arr), N);
+    const double truthRuns = dm.normalizeRuns(dm.calculateRuns(arr), N);
+
+    const int trials = 40;
+    double biasEst = 0.0, biasPlugIn = 0.0, runsEst = 0.0;
+    Estimator est(SamplingStrategy::CLUSTER, 0, 0.95, 5);
+    for (int t = 0; t < trials; ++t) {
+        Sampler s(arr, SAMPLE);
+        s.setStrategy(SamplingStrategy::CLUSTER);
+        s.createSample(50, 0, rng);
+        const auto e = est.estimate(s.getSample(), s.getSampleIndices());
+        biasEst    += e[Metric::Inversions].value - truthInv;
+        biasPlugIn += dm.normalizeInversions(dm.calculateInversions(s.getSample()), SAMPLE) - truthInv;
+        runsEst    += e[Metric::Runs].value;
+    }
+    biasEst /= trials;
+    biasPlugIn /= trials;
+
+    EXPECT_LT(biasPlugIn, -0.03);
+    EXPECT_LT(std::abs(biasEst), 0.5 * std::abs(biasPlugIn));
+    EXPECT_NEAR(runsEst / trials, truthRuns, 0.01);
+}
+
+TEST_F(EstimatorTest, OnlyInvRunsOscAreEstimated) {
+    DataGenerator gen;
+    auto arr = gen.generatePermutation(N);
+    Sampler s(arr, SAMPLE);
+    s.setStrategy(SamplingStrategy::STRATIFIED);
+    s.createSample(0, N / 20);
+
+    Estimator est(SamplingStrategy::STRATIFIED, 50, 0.95, 3);
+    const auto e = est.estimate(s.getSample(), s.getSampleIndices());
+    for (Metric m : {Metric::Inversions, Metric::Runs, Metric::Osc}) {
+        EXPECT_TRUE(Estimator::estimable(m));
+        EXPECT_TRUE(Estimator::estimable(m, SamplingStrategy::CLUSTER));
+    }
+    EXPECT_FALSE(std::isnan(e[Metric::Inversions].value));
+    for (Metric m : {Metric::Runs, Metric::Osc}) {
+        EXPECT_FALSE(Estimator::estimable(m, SamplingStrategy::STRATIFIED));
+        EXPECT_TRUE(std::isnan(e[m].value));
+        EXPECT_TRUE(std::isnan(e[m].stdError));
+    }
+    for (Metric m : {Metric::Rem, Metric::Dis, Metric::Ham}) {
+        EXPECT_FALSE(Estimator::estimable(m));
+        EXPECT_TRUE(std::isnan(e[m].value));
+        EXPECT_TRUE(std::isnan(e[m].stdError));
+    }
+
+    AdaptiveSampler::Config cfg;
+    cfg.metrics = {Metric::Rem};
+    EXPECT_THROW(AdaptiveSampler(arr, cfg, 1), std::invalid_argument);
+    cfg.metrics = {Metric::Runs};
+    EXPECT_THROW(AdaptiveSampler(arr, cfg, 1), std::invalid_argument);
+}
+
+TEST_F(EstimatorTest, RunsOsc_OnlyFromClusters) {
+    // 100 ascending runs of 100: a stratified sample's neighbours are ~25 apart, so its own
+    // Runs look like a random array's; only adjacent pairs inside clusters see the runs.
+    std::vector<int> arr(N);
+    for (int i = 0; i < N; ++i) arr[i] = i % 100;
+    const double truthRuns = dm.normalizeRuns(dm.calculateRuns(arr), N);
+    const double truthOsc  = dm.normalizeOsc(dm.calculateOsc(arr), N);
+
+    std::mt19937 rng(7);
+    const int trials = 20;
+    double runs = 0.0, osc = 0.0;
+    Estimator stratified(SamplingStrategy::STRATIFIED, 50, 0.95, 3);
+    Estimator cluster(SamplingStrategy::CLUSTER, 0, 0.95, 3);
+    for (int t = 0; t < trials; ++t) {
+        Sampler s(arr, SAMPLE);
+        s.setStrategy(SamplingStrategy::STRATIFIED);
+        s.createSample(0, N / 20);
+        const auto se = stratified.estimate(s.getSample(), s.getSampleIndices());
+        EXPECT_TRUE(std::isnan(se[Metric::Runs].value));
+        EXPECT_TRUE(std::isnan(se[Metric::Osc].value));
+        EXPECT_GT(dm.normalizeRuns(dm.calculateRuns(s.getSample()), SAMPLE), 10 * truthRuns);
+
+        Sampler c(arr, SAMPLE);
+        c.setStrategy(SamplingStrategy::CLUSTER);
+        c.createSample(20, 0, rng);
+        const auto ce = cluster.estimate(c.getSample(), c.getSampleIndices());
+        runs += ce[Metric::Runs].value;
+        osc  += ce[Metric::Osc].value;
+    }
+    EXPECT_NEAR(runs / trials, truthRuns, 0.005);
+    EXPECT_NEAR(osc / trials, truthOsc, 0.01);
+}
+
+TEST_F(EstimatorTest, Adaptive_StopsEarlyOnEasyArrays) {
+    DataGenerator gen;
+    auto sorted = gen.generateSorted(N, 0, 10 * N);
+    auto perm   = gen.generatePermutation(N);
+
+    AdaptiveSampler::Config cfg;
+    cfg.initialSize = 50;
+    cfg.budget = 2000;
+    cfg.targetStdError = 0.01;
+    cfg.metrics = {Metric::Inversions};
+
+    const auto easy = AdaptiveSampler(sorted, cfg, 1).run();
+    EXPECT_TRUE(easy.converged);
+    EXPECT_EQ(easy.rounds, 1);
+    EXPECT_EQ((int)easy.indices.size(), 50);
+
+    const auto hard = AdaptiveSampler(perm, cfg, 1).run();
+    EXPECT_GT(hard.indices.size(), easy.indices.size());
+    EXPECT_LE((int)hard.indices.size(), cfg.budget);
+    EXPECT_TRUE(std::is_sorted(hard.indices.begin(), hard.indices.end()));
+    EXPECT_EQ(std::adjacent_find(hard.indices.begin(), hard.indices.end()), hard.indices.end());
+    for (size_t k = 0; k < hard.indices.size(); ++k) EXPECT_EQ(hard.sample[k], perm[hard.indices[k]]);
+
+    cfg.strategy = SamplingStrategy::CLUSTER;
+    cfg.clusterSize = 25;
+    cfg.metrics = {Metric::Inversions, Metric::Runs};
+    const auto clustered = AdaptiveSampler(perm, cfg, 2).run();
+    EXPECT_LE((int)clustered.indices.size(), cfg.budget);
+    EXPECT_EQ(std::adjacent_find(clustered.indices.begin(), clustered.indices.end()), clustered.indices.end());
+}
+
+TEST_F(EstimatorTest, SamplingAccuracy_KnownErrors) {
+    namespace fs = std::filesystem;
+    const fs::path tmp = fs::temp_directory_path() / "disorder_accuracy_test";
+    fs::remove_all(tmp);
+    const fs::path set = tmp / "in" / "set";
+    const fs::path group = set / "samples" / "sqrt n" / "stratified sampling" / "g";
+    fs::create_directories(group);
+    // inv: truth 0, 1/3, 1; sample 0, 1, 1 -> errors 0, 2/3, 0
+    std::ofstream(set / "arrays.csv") << "1,2,3\n2,1,3\n3,2,1\n";
+    std::ofstream(group / "samples.csv") << "1,2\n2,1\n2,1\n";
+
+    const fs::path out = tmp / "accuracy.csv";
+    Evaluator{}.evaluateSamplingAccuracy((tmp / "in").string(), out.string(), 2, {Metric::Inversions});
+
+    std::ifstream acc(out);
+    std::string line;
+    ASSERT_TRUE(std::getline(acc, line));
+    int rows = 0;
+    while (std::getline(acc, line)) {
+        std::stringstream cells(line);
+        std::vector<std::string> c;
+        for (std::string cell; std::getline(cells, cell, ',');) c.push_back(cell);
+        ASSERT_EQ(c.size(), 8u) << line;
+        EXPECT_EQ(c[0], "set");
+        EXPECT_EQ(c[3], "inv");
+        EXPECT_EQ(c[4], "3");
+        // printed to 6 digits; the stratified estimate of inv is the sample's own value
+        EXPECT_NEAR(std::stod(c[5]), 2.0 / 9.0, 1e-5);
+        EXPECT_NEAR(std::stod(c[6]), std::sqrt(4.0 / 27.0), 1e-5);
+        // ranks (0, 1.5, 1.5) against (0, 1, 2)
+        EXPECT_NEAR(std::stod(c[7]), std::sqrt(3.0) / 2.0, 1e-5);
+        ++rows;
+    }
+    EXPECT_EQ(rows, 2); // sample and estimate
+
+    fs::remove_all(tmp);
+}
+
+#endif // ESTIMATORTEST_H
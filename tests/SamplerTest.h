@@ -3,12 +3,16 @@
 
 #define private public
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/Sampler.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/MultiSampler.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/SampleCodec.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/SamplePyramid.h"
 #undef private
 
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/DataGenerator.h"
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <cmath>
+#include <sstream>
 #include <vector>
 
 class SamplerTest : public ::testing::Test {
@@ -182,6 +186,192 @@ TEST_F(SamplerTest, Combined_Checks) {
     }
 }
 
+/* ========================== INDEX SELECTOR ========================= */
+
+TEST_F(SamplerTest, IndexSelector_SortedDistinctUniform) {
+    std::mt19937 rng(42);
+
+    // count, range and order for sparse (Algorithm D) and dense (Algorithm A) ratios
+    for (int take : {1, 5, 100, 2500, 9999, N}) {
+        int count = 0, last = -1;
+        IndexSelector::selectSorted(100, 100 + N, take, rng, [&](int idx) {
+            EXPECT_GT(idx, last);
+            EXPECT_GE(idx, 100);
+            EXPECT_LT(idx, 100 + N);
+            last = idx;
+            ++count;
+        });
+        EXPECT_EQ(count, take) << "take=" << take;
+    }
+
+    // every position is hit with frequency ~ take/range
+    const int range = 50, take = 7, trials = 20000;
+    std::vector<int> freq(range, 0);
+    for (int t = 0; t < trials; ++t) {
+        IndexSelector::selectSorted(0, range, take, rng, [&](int idx) { ++freq[idx]; });
+    }
+    const double expected = (double)trials * take / range;
+    for (int f : freq) {
+        EXPECT_NEAR(f, expected, 0.1 * expected);
+    }
+}
+
+/* =========================== MULTI SAMPLER ========================= */
+
+TEST_F(SamplerTest, MultiSampler_OneVisitPerArray) {
+    DataGenerator gen;
+    auto arr = gen.generatePermutation(N);
+    auto pos = valueToIndex(arr);
+
+    MultiSampler multi({
+        {SamplingStrategy::CLUSTER,    10, 0},
+        {SamplingStrategy::STRATIFIED, 0,  N / 10},
+        {SamplingStrategy::COMBINED,   0,  N / 4},
+    }, SAMPLE);
+
+    std::vector<size_t> seen;
+    multi.sampleAll(arr, [&](size_t g, const std::vector<int>& sample, const std::vector<int>& idx) {
+        seen.push_back(g);
+        EXPECT_EQ((int)sample.size(), SAMPLE) << "group=" << g;
+        EXPECT_EQ(SampleCodec::gather(arr, idx), sample) << "group=" << g;
+        if (multi.getGroups()[g].strategy == SamplingStrategy::STRATIFIED) {
+            EXPECT_TRUE(strictlyIncreasing(sampleIndices(sample, pos)));
+        }
+    });
+    EXPECT_EQ(seen, (std::vector<size_t>{0, 1, 2}));
+}
+
+/* ============================ RESERVOIR ============================ */
+
+TEST_F(SamplerTest, Reservoir_OrderPreservingAndUniform) {
+    DataGenerator gen;
+    auto arr = gen.generatePermutation(N);
+    auto pos = valueToIndex(arr);
+
+    Sampler s(arr, SAMPLE);
+    s.setStrategy(SamplingStrategy::RESERVOIR);
+    s.createSample(0, 0);
+    ASSERT_EQ((int)s.getSample().size(), SAMPLE);
+    EXPECT_TRUE(strictlyIncreasing(sampleIndices(s.getSample(), pos)));
+
+    // element-by-element and range feeding see the same stream length
+    ReservoirSampler byOne(SAMPLE, 7), byRange(SAMPLE, 7);
+    for (int v : arr) byOne.push(v);
+    byRange.pushRange(arr.begin(), arr.end());
+    EXPECT_EQ(byOne.getSeen(), N);
+    EXPECT_EQ(byRange.getSeen(), N);
+
+    // shorter stream than capacity keeps everything
+    ReservoirSampler small(SAMPLE, 1);
+    small.pushRange(arr.begin(), arr.begin() + 10);
+    EXPECT_EQ(small.sample(), std::vector<int>(arr.begin(), arr.begin() + 10));
+
+    // inclusion frequency ~ k/N for every position
+    const int range = 40, k = 5, trials = 40000;
+    std::vector<int> freq(range, 0);
+    for (int t = 0; t < trials; ++t) {
+        ReservoirSampler r(k, (std::uint32_t)t);
+        for (int i = 0; i < range; ++i) r.push(i);
+        for (const auto& e : r.entries()) ++freq[e.index];
+    }
+    const double expected = (double)trials * k / range;
+    for (int f : freq) {
+        EXPECT_NEAR(f, expected, 0.1 * expected);
+    }
+}
+
+/* ============================ INDEX CODEC ========================== */
+
+TEST_F(SamplerTest, SampleCodec_RoundTrip) {
+    std::vector<std::vector<int>> rows = {
+        {}, {0}, {3, 4, 5, 900, 9999}, {50, 10, 60, 0}, {N - 1}
+    };
+    std::stringstream ss;
+    for (const auto& r : rows) SampleCodec::writeRow(ss, r);
+
+    // dense sorted rows cost one byte per index
+    std::stringstream dense;
+    SampleCodec::writeRow(dense, {1, 2, 3, 4, 5, 6, 7, 8});
+    EXPECT_EQ(dense.str().size(), 9u);
+
+    std::vector<int> back;
+    for (const auto& r : rows) {
+        ASSERT_TRUE(SampleCodec::readRow(ss, back));
+        EXPECT_EQ(back, r);
+    }
+    EXPECT_FALSE(SampleCodec::readRow(ss, back));
+}
+
+/* ========================= VALUE STRATIFIED ======================== */
+
+TEST_F(SamplerTest, ValueStratified_ProportionalInPositionAndValue) {
+    DataGenerator gen;
+    auto arr = gen.generatePermutation(N);
+    auto pos = valueToIndex(arr);
+    std::mt19937 rng(99);
+
+    for (int strat : {N / 4, N / 10}) {
+        Sampler s(arr, SAMPLE);
+        s.setStrategy(SamplingStrategy::VALUE_STRATIFIED);
+        s.setValueStrata(4);
+        s.createSample(0, strat, rng);
+
+        ASSERT_EQ((int)s.getSample().size(), SAMPLE) << "strat=" << strat;
+        auto idx = sampleIndices(s.getSample(), pos);
+        EXPECT_TRUE(strictlyIncreasing(idx)) << "strat=" << strat;
+        EXPECT_EQ(idx, s.getSampleIndices());
+
+        // each value quartile gets ~ SAMPLE/4, up to sketch error and rounding per cell
+        std::vector<int> perQuartile(4, 0);
+        for (int v : s.getSample()) ++perQuartile[std::min(3, (v - 1) * 4 / N)];
+        for (int q = 0; q < 4; ++q) {
+            EXPECT_NEAR(perQuartile[q], SAMPLE / 4, 8) << "strat=" << strat << " q=" << q;
+        }
+    }
+
+    // few distinct values: every value is its own stratum and stays represented
+    auto fewValues = gen.generateRandom(N, 0, 100, 3);
+    Sampler few(fewValues, SAMPLE);
+    few.setStrategy(SamplingStrategy::VALUE_STRATIFIED);
+    few.createSample(0, N / 10, rng);
+    ASSERT_EQ((int)few.getSample().size(), SAMPLE);
+    std::vector<int> distinct = few.getSample();
+    std::sort(distinct.begin(), distinct.end());
+    EXPECT_EQ(std::unique(distinct.begin(), distinct.end()) - distinct.begin(), 3);
+}
+
+/* ============================= PYRAMID ============================= */
+
+TEST_F(SamplerTest, SamplePyramid_NestedLevels) {
+    std::mt19937 rng(3);
+    EXPECT_EQ(SamplePyramid::levelSizes(N, SAMPLE),
+              (std::vector<int>{100, 200, 400, 800, 1600, 3200, 6400}));
+
+    const auto inc = SamplePyramid::build(N, SAMPLE, rng);
+    ASSERT_EQ(inc.size(), 7u);
+
+    std::vector<int> prev;
+    for (size_t level = 0; level < inc.size(); ++level) {
+        const auto cur = SamplePyramid::level(inc, level);
+        EXPECT_EQ((int)cur.size(), SAMPLE << level);
+        EXPECT_TRUE(strictlyIncreasing(cur)) << "level=" << level;
+        EXPECT_TRUE(std::includes(cur.begin(), cur.end(), prev.begin(), prev.end())) << "level=" << level;
+        EXPECT_GE(cur.front(), 0);
+        EXPECT_LT(cur.back(), N);
+        prev = cur;
+    }
+
+    std::stringstream ss;
+    SamplePyramid::write(ss, inc);
+    SamplePyramid::write(ss, {});
+    std::vector<std::vector<int>> back;
+    ASSERT_TRUE(SamplePyramid::read(ss, back));
+    EXPECT_EQ(back, inc);
+    ASSERT_TRUE(SamplePyramid::read(ss, back));
+    EXPECT_TRUE(back.empty());
+    EXPECT_FALSE(SamplePyramid::read(ss, back));
+}
+
 #endif // SAMPLERTEST_H
 
 
@@ -0,0 +1,326 @@
+#ifndef SORTTEST_H
+#define SORTTEST_H
+
+#include <gtest/gtest.h>
+
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Analysis/SortBenchmark.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/src/Data/ExperimentConfigurator.h"
+
+#include <bit>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+class SortTest : public ::testing::Test {
+protected:
+    static constexpr int N = 300;
+};
+
+TEST_F(SortTest, Benchmark_EveryAlgorithmSortsGeneratedSets) {
+    namespace fs = std::filesystem;
+    const fs::path tmp = fs::temp_directory_path() / "disorder_bench_test";
+    fs::remove_all(tmp);
+
+    ExperimentConfigurator::Config cfg{N, 20, 0, N, (tmp / "in").generic_string()};
+    cfg.masterSeed = 5;
+    cfg.clusterGroups = {"sqrt"};
+    cfg.stratumGroups = {};
+    ExperimentConfigurator conf(cfg);
+    conf.generatePermutationSet(3);
+    conf.generateRandomSet(4, 3);     // heavy duplicates
+    conf.generateRunsSet(9, 3);
+    conf.generateWorkloadSet(ArrayType::ORGAN_PIPE_ARRAY, 3, 3);
+
+    SortBenchmark::Options opt;
+    opt.warmups = 1;
+    opt.repetitions = 3;
+    const auto results = SortBenchmark().run((tmp / "in").generic_string(),
+                                             (tmp / "bench.csv").generic_string(), opt);
+
+    const size_t algorithms = SortBenchmark::registry().size();
+    ASSERT_EQ(results.size(), 4 * 3 * algorithms);
+    std::set<std::string> sets;
+    for (const auto& r : results) {
+        EXPECT_TRUE(r.sorted) << r.algorithm << " on " << r.set << " #" << r.array;
+        EXPECT_EQ(r.n, static_cast<size_t>(N));
+        EXPECT_LE(r.minNs, r.medianNs);
+        EXPECT_LE(r.medianNs, r.p90Ns);
+        EXPECT_EQ(r.stats.has_value(), static_cast<bool>(std::find_if(
+            SortBenchmark::registry().begin(), SortBenchmark::registry().end(),
+            [&](const auto& alg) { return alg.name == r.algorithm; })->count));
+        sets.insert(r.set);
+    }
+    EXPECT_EQ(sets.size(), 4u);
+
+    // metrics are joined per array
+    const auto arr = ExperimentConfigurator::loadArrayByIndex(
+        (tmp / "in" / "run_array" / "300" / "r" / "r_9" / "arrays.csv").string(), 1);
+    const auto expected = Evaluator::normMetrics(arr);
+    for (const auto& r : results) {
+        if (r.set == "run_array/300/r/r_9" && r.array == 1) {
+            EXPECT_EQ(r.metrics, expected);
+        }
+    }
+
+    std::ifstream csv(tmp / "bench.csv");
+    std::string line;
+    size_t rows = 0;
+    while (std::getline(csv, line)) ++rows;
+    EXPECT_EQ(rows, results.size() + 1);
+
+    opt.algorithms = {"NoSuchSort"};
+    EXPECT_THROW(SortBenchmark().run((tmp / "in").generic_string(), (tmp / "x.csv").generic_string(), opt),
+                 std::invalid_argument);
+    fs::remove_all(tmp);
+}
+
+TEST_F(SortTest, Benchmark_Percentiles) {
+    const std::vector<double> v{5, 1, 4, 2, 3};
+    EXPECT_EQ(SortBenchmark::percentile(v, 0.0), 1);
+    EXPECT_EQ(SortBenchmark::percentile(v, 0.5), 3);
+    EXPECT_EQ(SortBenchmark::percentile(v, 1.0), 5);
+    EXPECT_EQ(SortBenchmark::percentile({}, 0.5), 0);
+}
+
+TEST_F(SortTest, Counters_InPlaceSpansAndExactCounts) {
+    std::mt19937 gen(11);
+    std::vector<std::unique_ptr<SortAlgorithm>> sorts;
+    sorts.push_back(std::make_unique<MergeSort<>>());
+    sorts.push_back(std::make_unique<QuickSort<>>());
+    sorts.push_back(std::make_unique<InsertionSort<>>());
+    sorts.push_back(std::make_unique<BinaryInsertionSort<>>());
+    sorts.push_back(std::make_unique<AdaptiveShiversSort<>>());
+    for (auto& sort : sorts) {
+        // only the span is sorted; the uninstrumented path records nothing
+        std::vector<int> a(N + 2);
+        for (auto& v : a) v = static_cast<int>(gen() % 50);
+        a.front() = 99;
+        a.back() = -1;
+        const SortStats stats = sort->sort(std::span<int>(a).subspan(1, N));
+        EXPECT_TRUE(std::is_sorted(a.begin() + 1, a.end() - 1));
+        EXPECT_EQ(a.front(), 99);
+        EXPECT_EQ(a.back(), -1);
+        EXPECT_EQ(stats.comparisons + stats.moves + stats.mergeCost + stats.bufferTraffic, 0u);
+    }
+
+    const std::uint64_t n = 1000;
+    std::vector<int> rev(n);
+    std::iota(rev.rbegin(), rev.rend(), 0);
+    const SortStats ins = InsertionSort<CountingCounter>().sort(rev);
+    EXPECT_EQ(ins.comparisons, n * (n - 1) / 2);
+    EXPECT_EQ(ins.moves, n * (n - 1) / 2 + (n - 1));
+
+    // top-down merge sort of 2^10 elements merges every element once per level
+    std::vector<int> a(1024);
+    for (auto& v : a) v = static_cast<int>(gen());
+    const SortStats ms = MergeSort<CountingCounter>().sort(a);
+    EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+    EXPECT_EQ(ms.mergeCost, 1024u * 10);
+    EXPECT_LE(ms.bufferTraffic, ms.mergeCost / 2);
+    EXPECT_LE(ms.moves, ms.mergeCost); // elements already in place are not moved
+}
+
+TEST_F(SortTest, Counters_DoNotOverflowOnQuadraticPaths) {
+    // a quadratic sort of 66000 elements passes INT_MAX comparisons; the counter is 64-bit
+    const std::uint64_t big = 3'000'000'000ull;
+    CountingCounter counter;
+    counter.compare(big);
+    counter.compare(big);
+    counter.move(big);
+    counter.merge(big);
+    counter.buffer(big);
+    counter.add(counter.stats());
+    const SortStats stats = counter.stats();
+    EXPECT_EQ(stats.comparisons, 4 * big);
+    EXPECT_EQ(stats.moves, 2 * big);
+    EXPECT_EQ(stats.mergeCost, 2 * big);
+    EXPECT_EQ(stats.bufferTraffic, 2 * big);
+
+    // and the quadratic sorts feed it exact counts
+    const std::uint64_t n = 2000;
+    std::vector<int> rev(n);
+    std::iota(rev.rbegin(), rev.rend(), 0);
+    EXPECT_EQ(InsertionSort<CountingCounter>().sort(rev).comparisons, n * (n - 1) / 2);
+    EXPECT_TRUE(std::is_sorted(rev.begin(), rev.end()));
+}
+
+TEST_F(SortTest, PowerSort_ClzNodePowerMatchesBitwise) {
+    std::mt19937_64 gen(3);
+    for (int t = 0; t < 200000; ++t) {
+        const size_t n = 2 + gen() % 2000000;
+        size_t cuts[3] = {gen() % n, gen() % n, gen() % (n + 1)};
+        std::sort(cuts, cuts + 3);
+        if (cuts[0] == cuts[1] || cuts[1] == cuts[2]) continue;
+        EXPECT_EQ(PowerSort<>::node_power(n, cuts[0], cuts[1], cuts[2]),
+                  PowerSort<>::node_power_bitwise(n, cuts[0] + cuts[1], cuts[1] + cuts[2]))
+            << n << " " << cuts[0] << " " << cuts[1] << " " << cuts[2];
+    }
+}
+
+TEST_F(SortTest, PowerSort_StableGenericAndReusable) {
+    std::mt19937 gen(21);
+    PowerSort<std::pair<int, int>> pairs; // one workspace for every call below
+    PowerSort<> ints;
+    for (int size : {0, 1, 2, 31, 32, 33, 100, 1000, 5000}) {
+        for (int shape = 0; shape < 5; ++shape) {
+            std::vector<std::pair<int, int>> a(size);
+            for (int i = 0; i < size; ++i) {
+                int key = static_cast<int>(gen() % (shape == 1 ? 7 : 100000));
+                if (shape == 2) key = i / 3;                       // sorted with ties
+                if (shape == 3) key = size - i;                    // strictly descending
+                if (shape == 4) key = (i % 500) + (i / 500) * 17;  // overlapping ascending runs
+                a[i] = {key, i};
+            }
+            auto expected = a;
+            std::stable_sort(expected.begin(), expected.end(),
+                             [](const auto& x, const auto& y) { return x.first < y.first; });
+            pairs.sort(a, std::ranges::less{}, &std::pair<int, int>::first);
+            EXPECT_EQ(a, expected) << "size " << size << " shape " << shape;
+
+            std::vector<int> v(size);
+            for (auto& x : v) x = static_cast<int>(gen() % 1000);
+            auto desc = v;
+            std::sort(desc.begin(), desc.end(), std::greater<>{});
+            ints.sort(v.begin(), v.end(), std::greater<>{});
+            EXPECT_EQ(v, desc);
+        }
+    }
+}
+
+TEST_F(SortTest, PowerSort_GallopsOverBlockInterleavedRuns) {
+    // two ascending runs whose values interleave in blocks of 1000
+    const int n = 100000, block = 1000;
+    std::vector<int> a;
+    for (int half = 0; half < 2; ++half)
+        for (int b = half; b < n / block; b += 2)
+            for (int i = 0; i < block; ++i) a.push_back(b * block + i);
+    const SortStats stats = PowerSort<int, CountingCounter>().sort(a);
+    EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+    EXPECT_EQ(stats.mergeCost, static_cast<std::uint64_t>(n));
+    // run detection costs n comparisons; element-wise merging would cost about n more
+    EXPECT_LT(stats.comparisons, static_cast<std::uint64_t>(n + n / 10));
+}
+
+TEST_F(SortTest, AdaptiveShiversSort_MergePolicyAndGalloping) {
+    // runs of 3, 3 and 24: the two short runs (level 0) merge first, then the result with
+    // the long one (level 3)
+    std::vector<int> a = {10, 11, 12, 5, 6, 7};
+    for (int i = 0; i < 24; ++i) a.push_back(i);
+    SortStats stats = AdaptiveShiversSort<CountingCounter>().sort(a);
+    EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+    EXPECT_EQ(stats.mergeCost, 6u + 30u);
+
+    // two block-interleaved runs are merged mostly by galloping
+    const int n = 100000, block = 1000;
+    std::vector<int> b;
+    for (int half = 0; half < 2; ++half)
+        for (int k = half; k < n / block; k += 2)
+            for (int i = 0; i < block; ++i) b.push_back(k * block + i);
+    AdaptiveShiversSort<CountingCounter> sort; // reused below
+    stats = sort.sort(b);
+    EXPECT_TRUE(std::is_sorted(b.begin(), b.end()));
+    EXPECT_EQ(stats.mergeCost, static_cast<std::uint64_t>(n));
+    EXPECT_LT(stats.comparisons, static_cast<std::uint64_t>(n + n / 10));
+    EXPECT_LE(stats.bufferTraffic, stats.mergeCost / 2);
+
+    std::mt19937 gen(49);
+    for (int size : {0, 1, 2, 100, 5000, 20000}) {
+        std::vector<int> v(size);
+        for (auto& x : v) x = static_cast<int>(gen() % 64);
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        stats = sort.sort(v);
+        EXPECT_EQ(v, expected);
+        EXPECT_LE(stats.bufferTraffic, stats.mergeCost / 2);
+        stats = sort.sort(v); // one run, nothing to merge
+        EXPECT_EQ(stats.mergeCost, 0u);
+    }
+}
+
+TEST_F(SortTest, PowerSort_ParallelMatchesSerial) {
+    std::mt19937 gen(48);
+    PowerSort<std::pair<int, int>> pairs;
+    PowerSort<std::pair<int, int>, CountingCounter> counted;
+    const int n = 300000;
+    for (int shape = 0; shape < 6; ++shape) {
+        std::vector<std::pair<int, int>> a(n);
+        for (int i = 0; i < n; ++i) {
+            int key = static_cast<int>(gen() % 1000000);
+            if (shape == 1) key = i;                              // sorted: one run over every chunk
+            if (shape == 2) key = n - i;                          // strictly descending
+            if (shape == 3) key = (i % 40000) + (i / 40000) * 5;  // long runs crossing chunk edges
+            if (shape == 4) key = static_cast<int>(gen() % 5);    // few distinct keys
+            if (shape == 5) key = (i / 7) % 2 ? i : n - i;        // short alternating runs
+            a[i] = {key, i};
+        }
+        auto expected = a;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const auto& x, const auto& y) { return x.first < y.first; });
+
+        auto b = a;
+        pairs.sortParallel(a, 4, std::ranges::less{}, &std::pair<int, int>::first);
+        EXPECT_EQ(a, expected) << "shape " << shape;
+
+        const SortStats stats = counted.sortParallel(b, 3, std::ranges::less{}, &std::pair<int, int>::first);
+        EXPECT_EQ(b, expected) << "shape " << shape;
+        EXPECT_GE(stats.comparisons, static_cast<std::uint64_t>(n - 1));
+    }
+
+    // below PARALLEL_MIN, and with one thread, the serial sort runs
+    std::vector<int> small(1000), serial;
+    for (auto& x : small) x = static_cast<int>(gen() % 100);
+    serial = small;
+    const SortStats s1 = PowerSort<int, CountingCounter>().sortParallel(small, 8);
+    const SortStats s2 = PowerSort<int, CountingCounter>().sort(serial);
+    EXPECT_EQ(small, serial);
+    EXPECT_EQ(s1.comparisons, s2.comparisons);
+}
+
+TEST_F(SortTest, QuickSort_DuplicatesPatternsAndSortedInputStayNLogN) {
+    std::mt19937 gen(50);
+    const std::uint64_t n = 100000;
+    const std::uint64_t bound = 3 * n * std::bit_width(n); // 3 n log2 n
+    QuickSort<CountingCounter> sort;
+    for (int shape = 0; shape < 9; ++shape) {
+        std::vector<int> a(n);
+        for (std::uint64_t i = 0; i < n; ++i) {
+            const int x = static_cast<int>(i);
+            switch (shape) {
+                case 0: a[i] = static_cast<int>(gen()); break;
+                case 1: a[i] = static_cast<int>(gen() % 2); break;    // random_array with k = 2
+                case 2: a[i] = static_cast<int>(gen() % 16); break;
+                case 3: a[i] = 7; break;                               // all equal
+                case 4: a[i] = x; break;                               // sorted
+                case 5: a[i] = -x; break;                              // reversed
+                case 6: a[i] = std::min(x, static_cast<int>(n) - x); break; // organ pipe
+                case 7: a[i] = x % 1000; break;                        // sawtooth
+                case 8: a[i] = x % 2 ? x : static_cast<int>(n) - x; break; // interleaved
+            }
+        }
+        auto expected = a;
+        std::sort(expected.begin(), expected.end());
+        const SortStats stats = sort.sort(a);
+        EXPECT_EQ(a, expected) << "shape " << shape;
+        EXPECT_LT(stats.comparisons, bound) << "shape " << shape;
+        if (shape >= 3 && shape <= 5) {
+            // equal keys finish in one partition; sorted and reversed in a few linear passes
+            EXPECT_LT(stats.comparisons, 4 * n) << "shape " << shape;
+        }
+    }
+
+    for (int size : {0, 1, 2, 3, 23, 24, 25, 128, 129, 1000}) {
+        std::vector<int> v(size);
+        for (auto& x : v) x = static_cast<int>(gen() % 10);
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        sort.sort(v);
+        EXPECT_EQ(v, expected) << "size " << size;
+    }
+}
+
+#endif //SORTTEST_H
@@ -2,6 +2,8 @@
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/tests/DisorderMetricsTest.h"
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/tests/SamplerTest.h"
 #include "C:/Users/markg/CLionProjects/DisorderMetrics/tests/DataGeneratorTest.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/tests/EstimatorTest.h"
+#include "C:/Users/markg/CLionProjects/DisorderMetrics/tests/SortTest.h"
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);